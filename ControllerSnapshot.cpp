@@ -0,0 +1,95 @@
+/////////////////////////////////////////////////////////////
+// CONTROLLERSNAPSHOT.CPP - Warm Restart State
+/////////////////////////////////////////////////////////////
+
+#include "ControllerSnapshot.h"
+#include <QDataStream>
+#include <QDebug>
+#include <QFile>
+#include <QSaveFile>
+
+static const quint32 SNAPSHOT_MAGIC   = 0x53524853;   // "SRHS"
+static const quint16 SNAPSHOT_VERSION = 1;
+
+// A forecast never has more points than this; guards the reader
+// against a corrupt count
+static const qint32 MAX_FORECAST_POINTS = 10000;
+
+static void writeSeries(QDataStream &out, const QVector<WeatherData> &series)
+{
+    out << qint32(series.size());
+    for (const WeatherData &p : series)
+        out << p.timestamp.toMSecsSinceEpoch() << p.value;
+}
+
+static bool readSeries(QDataStream &in, QVector<WeatherData> &series)
+{
+    qint32 count = 0;
+    in >> count;
+    if (in.status() != QDataStream::Ok || count < 0 || count > MAX_FORECAST_POINTS)
+        return false;
+
+    series.resize(0);
+    series.reserve(count);
+    for (qint32 i = 0; i < count; i++) {
+        qint64 ms;
+        double value;
+        in >> ms >> value;
+        series.append({QDateTime::fromMSecsSinceEpoch(ms), value});
+    }
+    return in.status() == QDataStream::Ok;
+}
+
+bool ControllerSnapshot::save(const QString &path) const
+{
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qWarning() << "ControllerSnapshot: cannot write" << path << file.errorString();
+        return false;
+    }
+
+    QDataStream out(&file);
+    out.setVersion(QDataStream::Qt_5_0);
+    out << SNAPSHOT_MAGIC << SNAPSHOT_VERSION
+        << savedMs << lastTickMs << state << releaseReason
+        << valveOpen << autoControl
+        << lastDepth << lastMoisture << lastCumRain;
+    writeSeries(out, rainAmount);
+    writeSeries(out, rainProb);
+    writeSeries(out, temperature);
+
+    if (!file.commit()) {
+        qWarning() << "ControllerSnapshot: cannot commit" << path << file.errorString();
+        return false;
+    }
+    return true;
+}
+
+bool ControllerSnapshot::load(const QString &path)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly))
+        return false;
+
+    QDataStream in(&file);
+    in.setVersion(QDataStream::Qt_5_0);
+
+    quint32 magic = 0;
+    quint16 version = 0;
+    in >> magic >> version;
+    if (magic != SNAPSHOT_MAGIC || version != SNAPSHOT_VERSION) {
+        qWarning() << "ControllerSnapshot: ignoring unrecognised" << path;
+        return false;
+    }
+
+    in >> savedMs >> lastTickMs >> state >> releaseReason
+       >> valveOpen >> autoControl
+       >> lastDepth >> lastMoisture >> lastCumRain;
+
+    if (!readSeries(in, rainAmount) || !readSeries(in, rainProb)
+        || !readSeries(in, temperature)) {
+        qWarning() << "ControllerSnapshot: truncated" << path;
+        return false;
+    }
+    return true;
+}
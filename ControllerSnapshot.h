@@ -0,0 +1,40 @@
+/////////////////////////////////////////////////////////////
+// CONTROLLERSNAPSHOT.H - Warm Restart State Header
+/////////////////////////////////////////////////////////////
+
+#ifndef CONTROLLERSNAPSHOT_H
+#define CONTROLLERSNAPSHOT_H
+
+#include <QString>
+#include <QVector>
+
+#include "noaaweatherfetcher.h"
+
+// What the controller needs to pick up where it left off after a
+// restart or power cut. Written whole at every transition; the
+// chart histories are not in it, they come back from the
+// TimeSeriesStore.
+struct ControllerSnapshot {
+    qint64 savedMs       = 0;
+    qint64 lastTickMs    = 0;        // Last monitoring/release tick
+    qint32 state         = 0;        // SystemState
+    qint32 releaseReason = 0;        // ReleaseReason
+    bool   valveOpen     = false;
+    bool   autoControl   = true;
+    double lastDepth     = 0;
+    double lastMoisture  = 0;
+    double lastCumRain   = 0;
+
+    // Last forecast, to redraw the weather chart without a fetch
+    QVector<WeatherData> rainAmount;
+    QVector<WeatherData> rainProb;
+    QVector<WeatherData> temperature;
+
+    // Atomic replace (write, fsync, rename)
+    bool save(const QString &path) const;
+
+    // False if missing, unreadable or from another version
+    bool load(const QString &path);
+};
+
+#endif // CONTROLLERSNAPSHOT_H
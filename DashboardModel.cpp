@@ -0,0 +1,89 @@
+/////////////////////////////////////////////////////////////
+// DASHBOARDMODEL.CPP - Info Panel View Model
+/////////////////////////////////////////////////////////////
+
+#include "DashboardModel.h"
+#include <QtGlobal>
+
+QString DashboardModel::Reading::text() const
+{
+    if (level == Offline)
+        return QStringLiteral("--");
+    return QString::number(tenths / 10.0, 'f', 1);
+}
+
+void DashboardModel::setDepth(double cm, double barrelCm, double overflowCm, bool sensorOk)
+{
+    const int percent = qBound(0, static_cast<int>(cm / barrelCm * 100), 100);
+    if (!sensorOk)
+        setReading(depthReading, Depth, 0, 0, Offline);
+    else
+        setReading(depthReading, Depth, cm, percent, cm > overflowCm ? Alarm : Normal);
+}
+
+void DashboardModel::setMoisture(double percent, double thresholdPercent)
+{
+    setReading(moistureReading, Moisture, percent,
+               qBound(0, static_cast<int>(percent), 100),
+               percent < thresholdPercent ? Alarm : Normal);
+}
+
+void DashboardModel::setRain(double mm, double thresholdMm)
+{
+    setReading(rainReading, Rain, mm,
+               qBound(0, static_cast<int>(mm / (thresholdMm * 2) * 100), 100),
+               mm > thresholdMm ? Wet : Plain);
+}
+
+void DashboardModel::setMode(bool releasing, const QString &reason)
+{
+    if (releasing == isReleasing && reason == releaseReason)
+        return;
+    isReleasing   = releasing;
+    releaseReason = reason;
+    dirty |= Mode;
+}
+
+// The valve card follows the valve; the button also follows the
+// control mode
+void DashboardModel::setValve(bool open, bool autoControl)
+{
+    if (open != isOpen)
+        dirty |= Valve | Button;
+    if (autoControl != isAuto)
+        dirty |= Button;
+    isOpen = open;
+    isAuto = autoControl;
+}
+
+int DashboardModel::takeDirty()
+{
+    const int cards = dirty;
+    dirty = 0;
+    return cards;
+}
+
+const char *DashboardModel::levelName(Level level)
+{
+    switch (level) {
+    case Plain:   return "plain";
+    case Normal:  return "normal";
+    case Wet:     return "wet";
+    case Ok:      return "ok";
+    case Alarm:   return "alarm";
+    case Offline: return "offline";
+    }
+    return "plain";
+}
+
+void DashboardModel::setReading(Reading &reading, Card card, double value, int percent,
+                                Level level)
+{
+    const int tenths = qRound(value * 10);
+    if (tenths == reading.tenths && percent == reading.percent && level == reading.level)
+        return;
+    reading.tenths  = tenths;
+    reading.percent = percent;
+    reading.level   = level;
+    dirty |= card;
+}
@@ -0,0 +1,82 @@
+/////////////////////////////////////////////////////////////
+// DASHBOARDMODEL.H - Info Panel View Model Header
+/////////////////////////////////////////////////////////////
+
+#ifndef DASHBOARDMODEL_H
+#define DASHBOARDMODEL_H
+
+#include <QString>
+
+// What the info panel shows, held at the precision it is shown at.
+// Setters compare with the shown value and mark only the cards that
+// changed; the window redraws those and leaves the rest alone, so a
+// tick that changes no reading touches no widget.
+//
+// Colours are not kept here. Each card has a Level, which the window
+// sets as the "level" property of its widgets; the one window
+// stylesheet maps levels to colours.
+class DashboardModel
+{
+public:
+    enum Card {
+        Depth    = 0x01,
+        Moisture = 0x02,
+        Rain     = 0x04,
+        Mode     = 0x08,
+        Valve    = 0x10,
+        Button   = 0x20,
+        AllCards = 0x3f
+    };
+
+    enum Level {
+        Plain,          // No colour of its own
+        Normal,
+        Wet,
+        Ok,
+        Alarm,
+        Offline
+    };
+
+    // A number with one decimal, its bar fill and its level
+    struct Reading {
+        int   tenths  = 0;
+        int   percent = 0;
+        Level level   = Plain;
+
+        QString text() const;           // "12.3", "--" when Offline
+    };
+
+    void setDepth(double cm, double barrelCm, double overflowCm, bool sensorOk);
+    void setMoisture(double percent, double thresholdPercent);
+    void setRain(double mm, double thresholdMm);
+    void setMode(bool releasing, const QString &reason);
+    void setValve(bool open, bool autoControl);
+
+    // Cards changed since the last call; clears them
+    int takeDirty();
+
+    // Value of the "level" property for a level
+    static const char *levelName(Level level);
+
+    const Reading &depth() const    { return depthReading; }
+    const Reading &moisture() const { return moistureReading; }
+    const Reading &rain() const     { return rainReading; }
+    bool releasing() const          { return isReleasing; }
+    const QString &reason() const   { return releaseReason; }
+    bool valveOpen() const          { return isOpen; }
+    bool autoControl() const        { return isAuto; }
+
+private:
+    Reading depthReading;
+    Reading moistureReading;
+    Reading rainReading;
+    bool    isReleasing = false;
+    QString releaseReason;
+    bool    isOpen      = false;
+    bool    isAuto      = true;
+    int     dirty       = AllCards;     // First redraw paints everything
+
+    void setReading(Reading &reading, Card card, double value, int percent, Level level);
+};
+
+#endif // DASHBOARDMODEL_H
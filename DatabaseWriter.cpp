@@ -3,89 +3,246 @@
 /////////////////////////////////////////////////////////////
 
 #include "DatabaseWriter.h"
+#include "HttpSink.h"
+#include "LocalSinks.h"
+#include <QFileInfo>
+#include <QSettings>
+#include <QStandardPaths>
 
 DatabaseWriter::DatabaseWriter(QObject *parent)
     : QObject(parent)
 {
-    manager = new QNetworkAccessManager(this);
+    // Default deadbands for the live sensors
+    setDeadband("depth_sensor",    0.5);   // cm
+    setDeadband("moisture_sensor", 1.0);   // %
+    setDeadband("valve_state",     0.0);   // every open/shut edge
 
-    // API endpoint - UPDATE THIS TO YOUR EC2 IP
-    apiUrl = QUrl("http://54.213.147.59:5000/sensor");
+    QString configDir = QStandardPaths::writableLocation(QStandardPaths::AppConfigLocation);
+    if (!loadSinkConfig(configDir + "/sinks.ini")) {
+        // API endpoint - UPDATE THIS TO YOUR EC2 IP
+        QString dataDir = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
+        addSink(new HttpSink("http", QUrl("http://54.213.147.59:5000/sensor"),
+                             dataDir + "/upload-queue.wal"),
+                true);
+    }
 }
 
-// Send a single reading to the API
-void DatabaseWriter::sendReading(const QString &sensorId, double value,
-                                 const QString &unit, const QDateTime &timestamp)
+DatabaseWriter::~DatabaseWriter()
+{
+    // Threaded sinks deliver their queue, then delete themselves as
+    // their thread finishes; the rest are children of this object
+    for (const SinkEntry &entry : sinkEntries) {
+        if (entry.thread) {
+            TelemetrySink *sink = entry.sink;
+            QMetaObject::invokeMethod(sink, [sink]() { sink->drain(); },
+                                      Qt::BlockingQueuedConnection);
+            entry.thread->quit();
+            entry.thread->wait();
+            delete entry.thread;
+        }
+        delete entry.reducer;
+    }
+}
+
+// ================================================================
+//  Sinks
+// ================================================================
+
+void DatabaseWriter::addSink(TelemetrySink *sink, bool reduced)
 {
-    QJsonObject json;
-    json["sensor_id"] = sensorId;
-    json["value"] = QString::number(value, 'f', 2).toDouble();
-    json["unit"] = unit;
+    SinkEntry entry;
+    entry.sink = sink;
+
+    if (reduced) {
+        entry.reducer = new StreamReducer();
+        entry.reducer->heartbeatInterval = heartbeatInterval;
+        for (auto it = deadbands.constBegin(); it != deadbands.constEnd(); ++it)
+            entry.reducer->setDeadband(it.key(), it.value());
+    }
 
-    if (timestamp.isValid()) {
-        json["timestamp"] = timestamp.toString(Qt::ISODate);
+    if (sink->wantsOwnThread()) {
+        entry.thread = new QThread();
+        entry.thread->setObjectName("sink-" + sink->name());
+        sink->setParent(nullptr);
+        sink->moveToThread(entry.thread);
+        connect(entry.thread, &QThread::finished, sink, &QObject::deleteLater);
+        entry.thread->start();
     } else {
-        json["timestamp"] = QDateTime::currentDateTime().toString(Qt::ISODate);
+        sink->setParent(this);
+    }
+
+    sinkEntries.append(entry);
+}
+
+// Build sinks from an INI file; one group per sink. Returns false
+// if the file doesn't exist or defines no sinks.
+bool DatabaseWriter::loadSinkConfig(const QString &path)
+{
+    if (!QFileInfo::exists(path))
+        return false;
+
+    QSettings ini(path, QSettings::IniFormat);
+    QString dataDir = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
+    int added = 0;
+
+    for (const QString &group : ini.childGroups()) {
+        ini.beginGroup(group);
+        QString type = ini.value("type", group).toString();
+        bool reduced = ini.value("reduced", type == "http").toBool();
+
+        TelemetrySink *sink = nullptr;
+        if (type == "http") {
+            HttpSink *http = new HttpSink(group, QUrl(ini.value("url").toString()),
+                                          ini.value("queue", dataDir + "/upload-queue-"
+                                                    + group + ".wal").toString());
+            QString format = ini.value("format", "auto").toString();
+            if (format == "json")
+                http->wireFormat = WireFormat::Json;
+            else if (format == "cbor")
+                http->wireFormat = WireFormat::Cbor;
+            http->setDailyBudget(ini.value("dailyBytes", 0).toLongLong(),
+                                 ini.value("dailyRequests", 0).toInt());
+            sink = http;
+        } else if (type == "file") {
+            sink = new FileSink(group, ini.value("path").toString());
+        } else if (type == "unix") {
+            sink = new UnixSocketSink(group, ini.value("path").toString());
+        } else if (type == "stdout") {
+            sink = new StdoutSink(group);
+        } else {
+            qWarning() << "sinks.ini: unknown sink type" << type << "in" << group;
+        }
+
+        if (sink) {
+            addSink(sink, reduced);
+            added++;
+        }
+        ini.endGroup();
+    }
+    return added > 0;
+}
+
+QVector<TelemetrySink*> DatabaseWriter::sinks() const
+{
+    QVector<TelemetrySink*> out;
+    for (const SinkEntry &entry : sinkEntries)
+        out.append(entry.sink);
+    return out;
+}
+
+QVector<SinkMetrics> DatabaseWriter::metrics() const
+{
+    QVector<SinkMetrics> out;
+    for (const SinkEntry &entry : sinkEntries) {
+        SinkMetrics m = entry.sink->metrics();
+        m.readingsReduced = entry.reduced;
+        out.append(m);
     }
+    return out;
+}
 
-    postJson(json);
+void DatabaseWriter::setDeadband(const QString &sensorId, double deadband)
+{
+    deadbands[sensorId] = deadband;
+    for (const SinkEntry &entry : sinkEntries)
+        if (entry.reducer)
+            entry.reducer->setDeadband(sensorId, deadband);
+}
+
+void DatabaseWriter::setHeartbeatInterval(int seconds)
+{
+    heartbeatInterval = seconds;
+    for (const SinkEntry &entry : sinkEntries)
+        if (entry.reducer)
+            entry.reducer->heartbeatInterval = seconds;
 }
 
-// Send an entire weather forecast array
+// ================================================================
+//  Fan-out
+// ================================================================
+
+// Send a single reading to every sink
+void DatabaseWriter::sendReading(const QString &sensorId, double value,
+                                 const QString &unit, const QDateTime &timestamp,
+                                 UploadPriority priority)
+{
+    SensorReading reading;
+    reading.priority    = priority;
+    reading.sensorId    = sensorId;
+    reading.unit        = unit;
+    reading.value       = value;
+    reading.timestampMs = timestamp.isValid()
+                              ? timestamp.toMSecsSinceEpoch()
+                              : QDateTime::currentMSecsSinceEpoch();
+
+    for (const SinkEntry &entry : sinkEntries)
+        entry.sink->submit(reading);
+}
+
+// Send a weather forecast array: all of it to full-rate sinks,
+// only the delta to reduced ones
 void DatabaseWriter::sendWeatherData(const QString &sensorId, const QString &unit,
                                      const QVector<WeatherData> &weatherData)
 {
-    for (const auto &data : weatherData) {
-        sendReading(sensorId, data.value, unit, data.timestamp);
+    for (SinkEntry &entry : sinkEntries) {
+        if (entry.reducer) {
+            const QVector<SensorReading> delta =
+                entry.reducer->forecastDelta(sensorId, unit, weatherData);
+            // A non-empty delta also carries the run marker
+            if (!delta.isEmpty())
+                entry.reduced += weatherData.size() - (delta.size() - 1);
+            for (const SensorReading &reading : delta)
+                entry.sink->submit(reading);
+        } else {
+            SensorReading reading;
+            reading.sensorId = sensorId;
+            reading.unit     = unit;
+            reading.priority = UploadPriority::Forecast;
+            for (const auto &data : weatherData) {
+                reading.timestampMs = data.timestamp.toMSecsSinceEpoch();
+                reading.value       = data.value;
+                entry.sink->submit(reading);
+            }
+        }
     }
 
-    //qDebug() << "Sent" << weatherData.size() << "readings for" << sensorId;
+    //qDebug() << "Sent forecast run of" << weatherData.size() << "points for" << sensorId;
 }
 
 // Convenience: send a depth sensor reading with current timestamp
 void DatabaseWriter::sendDepthReading(double depthCm)
 {
-    sendReading("depth_sensor", depthCm, "cm");
+    sendLiveReading("depth_sensor", depthCm, "cm", UploadPriority::Live);
 }
 
 // Convenience: send a moisture sensor reading with current timestamp
 void DatabaseWriter::sendMoistureReading(double moist)
 {
-    sendReading("moisture_sensor", moist, "%");
+    sendLiveReading("moisture_sensor", moist, "%", UploadPriority::Live);
 }
 
 // Convenience: send valve state with current timestamp
 void DatabaseWriter::sendValveState(bool open)
 {
-    sendReading("valve_state", open ? 1.0 : 0.0, "bool");
+    sendLiveReading("valve_state", open ? 1.0 : 0.0, "bool", UploadPriority::Safety);
 }
 
-// Internal: POST a JSON object to the API
-void DatabaseWriter::postJson(const QJsonObject &json)
+// Internal: live readings go to every full-rate sink, and to a
+// reduced sink only if its reducer sees an exception
+void DatabaseWriter::sendLiveReading(const QString &sensorId, double value,
+                                     const QString &unit, UploadPriority priority)
 {
-    QJsonDocument doc(json);
-    QByteArray data = doc.toJson();
-
-    QNetworkRequest request(apiUrl);
-    request.setHeader(QNetworkRequest::ContentTypeHeader, "application/json");
+    SensorReading reading;
+    reading.priority    = priority;
+    reading.sensorId    = sensorId;
+    reading.unit        = unit;
+    reading.value       = value;
+    reading.timestampMs = QDateTime::currentMSecsSinceEpoch();
 
-    QNetworkReply *reply = manager->post(request, data);
-    connect(reply, &QNetworkReply::finished, this, [this, reply]() {
-        onReplyFinished(reply);
-    });
-}
-
-// Handle API response
-void DatabaseWriter::onReplyFinished(QNetworkReply *reply)
-{
-    if (reply->error() != QNetworkReply::NoError) {
-        failCount++;
-        if (failCount <= 3) {
-            qWarning() << "DB write failed:" << reply->errorString();
-        }
-        if (failCount == 3) {
-            qWarning() << "Suppressing further DB error messages...";
-        }
+    for (SinkEntry &entry : sinkEntries) {
+        if (!entry.reducer || entry.reducer->acceptLive(reading))
+            entry.sink->submit(reading);
+        else
+            entry.reduced++;
     }
-    reply->deleteLater();
 }
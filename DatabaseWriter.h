@@ -6,48 +6,83 @@
 #define DATABASEWRITER_H
 
 #include <QObject>
-#include <QNetworkAccessManager>
-#include <QNetworkRequest>
-#include <QNetworkReply>
-#include <QJsonObject>
-#include <QJsonDocument>
-#include <QUrl>
 #include <QDebug>
 #include <QDateTime>
 #include <QVector>
+#include <QHash>
+#include <QThread>
 
 #include "noaaweatherfetcher.h"
+#include "TelemetrySink.h"
+#include "StreamReducer.h"
 
+// Front end of the telemetry pipeline. Every reading is fanned out
+// to a set of sinks (HTTP, file, Unix socket, stdout). A sink can be
+// "reduced": it then only gets what its StreamReducer passes, so a
+// site can log locally at full rate while uploading a thin stream.
+//
+// Sinks are read from sinks.ini in the app config directory, e.g.
+//   [http]
+//   type=http
+//   url=http://54.213.147.59:5000/sensor
+//   reduced=true
+//   [log]
+//   type=file
+//   path=/home/pi/smartstorm.ndjson
+// Without that file a single reduced HTTP sink to the EC2 API is used.
 class DatabaseWriter : public QObject
 {
     Q_OBJECT
 
 public:
     explicit DatabaseWriter(QObject *parent = nullptr);
+    ~DatabaseWriter();
 
-    // Generic: send a single reading to the API
+    // Generic: send a single reading to every sink
     void sendReading(const QString &sensorId, double value,
-                     const QString &unit, const QDateTime &timestamp = QDateTime());
+                     const QString &unit, const QDateTime &timestamp = QDateTime(),
+                     UploadPriority priority = UploadPriority::Live);
 
-    // Weather forecasts: send an entire forecast array
+    // Weather forecasts: full-rate sinks get the whole array,
+    // reduced sinks only new or changed points plus a run marker.
     // sensorId examples: "precip_amount", "precip_prob", "temperature"
     void sendWeatherData(const QString &sensorId, const QString &unit,
                          const QVector<WeatherData> &weatherData);
 
-    // Convenience methods for specific data types
+    // Convenience methods for specific data types. These are live
+    // readings and reduced sinks apply report-by-exception.
     void sendDepthReading(double depthCm);
     void sendMoistureReading(double moist);
     void sendValveState(bool open);
 
-private slots:
-    void onReplyFinished(QNetworkReply *reply);
+    // Report-by-exception settings for all reduced sinks
+    void setDeadband(const QString &sensorId, double deadband);
+    void setHeartbeatInterval(int seconds);
+
+    // Sinks. The writer takes ownership; sinks that do blocking
+    // I/O run on a thread of their own.
+    void addSink(TelemetrySink *sink, bool reduced);
+    bool loadSinkConfig(const QString &path);
+    QVector<TelemetrySink*> sinks() const;
+
+    // Per-sink latency, throughput, queue and drop counters
+    QVector<SinkMetrics> metrics() const;
 
 private:
-    QNetworkAccessManager *manager;
-    QUrl apiUrl;
+    struct SinkEntry {
+        TelemetrySink *sink    = nullptr;
+        StreamReducer *reducer = nullptr;   // Null for full-rate sinks
+        QThread       *thread  = nullptr;   // Null if on the caller's thread
+        quint64        reduced = 0;         // Readings the reducer held back
+    };
+    QVector<SinkEntry> sinkEntries;
+
+    // Applied to every reducer, including ones added later
+    QHash<QString, double> deadbands;
+    int heartbeatInterval = 6 * 3600;
 
-    void postJson(const QJsonObject &json);
-    int failCount = 0;
+    void sendLiveReading(const QString &sensorId, double value, const QString &unit,
+                         UploadPriority priority);
 };
 
 #endif // DATABASEWRITER_H
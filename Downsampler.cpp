@@ -0,0 +1,59 @@
+/////////////////////////////////////////////////////////////
+// DOWNSAMPLER.CPP - Chart Point Reduction
+/////////////////////////////////////////////////////////////
+
+#include "Downsampler.h"
+#include <cmath>
+
+void Downsampler::lttb(const QPointF *points, int count, int threshold, QVector<QPointF> &out)
+{
+    out.resize(0);
+    if (count <= threshold || threshold < 3) {
+        out.reserve(count);
+        for (int i = 0; i < count; i++)
+            out.append(points[i]);
+        return;
+    }
+
+    out.reserve(threshold);
+    out.append(points[0]);
+
+    // Buckets over points[1 .. count-2], 'every' points wide
+    const double every = double(count - 2) / (threshold - 2);
+    int kept = 0;
+
+    for (int b = 0; b < threshold - 2; b++) {
+        // Average of the next bucket (the last point for the last one)
+        const int avgStart = int((b + 1) * every) + 1;
+        const int avgEnd   = qMin(int((b + 2) * every) + 1, count);
+        double avgX = 0, avgY = 0;
+        for (int i = avgStart; i < avgEnd; i++) {
+            avgX += points[i].x();
+            avgY += points[i].y();
+        }
+        avgX /= avgEnd - avgStart;
+        avgY /= avgEnd - avgStart;
+
+        // Point in this bucket with the largest triangle; the ½ is
+        // dropped since only the comparison matters
+        const double ax = points[kept].x();
+        const double ay = points[kept].y();
+        const int start = int(b * every) + 1;
+        const int end   = int((b + 1) * every) + 1;
+        double maxArea = -1;
+        int next = start;
+        for (int i = start; i < end; i++) {
+            const double area = std::fabs((ax - avgX) * (points[i].y() - ay)
+                                          - (ax - points[i].x()) * (avgY - ay));
+            if (area > maxArea) {
+                maxArea = area;
+                next = i;
+            }
+        }
+
+        out.append(points[next]);
+        kept = next;
+    }
+
+    out.append(points[count - 1]);
+}
@@ -0,0 +1,26 @@
+/////////////////////////////////////////////////////////////
+// DOWNSAMPLER.H - Chart Point Reduction Header
+/////////////////////////////////////////////////////////////
+
+#ifndef DOWNSAMPLER_H
+#define DOWNSAMPLER_H
+
+#include <QPointF>
+#include <QVector>
+
+// Reduces a line to about as many points as it has pixels, so
+// QtCharts paints a long history as fast as a short one.
+class Downsampler
+{
+public:
+    // Largest-Triangle-Three-Buckets (Steinarsson, 2013): keeps the
+    // first and last points and, from each of threshold - 2 equal
+    // buckets in between, the point forming the largest triangle
+    // with the previously kept point and the next bucket's average.
+    // Peaks and troughs survive, unlike every-Nth sampling. 'points'
+    // must be sorted by x; copied through unchanged if count <=
+    // threshold or threshold < 3.
+    static void lttb(const QPointF *points, int count, int threshold, QVector<QPointF> &out);
+};
+
+#endif // DOWNSAMPLER_H
@@ -0,0 +1,246 @@
+/////////////////////////////////////////////////////////////
+// GORILLACODEC.CPP - Compressed Time-Series Block Codec
+/////////////////////////////////////////////////////////////
+
+#include "GorillaCodec.h"
+#include <QtAlgorithms>
+#include <cstring>
+
+// Delta-of-delta size classes, smallest first (see header)
+struct DodBucket {
+    int     prefixBits;
+    quint64 prefix;
+    int     valueBits;
+};
+static const DodBucket DOD_BUCKETS[] = {
+    { 2, 0x1,  7 },    // 01
+    { 3, 0x1, 12 },    // 001
+    { 4, 0x1, 20 },    // 0001
+    { 5, 0x1, 32 },    // 00001
+    { 5, 0x0, 64 }     // 00000
+};
+static const int DOD_BUCKET_COUNT = 5;
+
+static inline quint64 lowBits(quint64 v, int n)
+{
+    return n >= 64 ? v : v & ((quint64(1) << n) - 1);
+}
+
+static inline bool fitsSigned(qint64 v, int bits)
+{
+    if (bits >= 64)
+        return true;
+    const qint64 limit = qint64(1) << (bits - 1);
+    return v >= -limit && v < limit;
+}
+
+// Write n bits MSB-first into a zero-filled buffer; with a null
+// buffer only the position moves (used to size a sample)
+static inline void putBits(uchar *buf, quint32 &pos, quint64 value, int n)
+{
+    if (!buf) {
+        pos += n;
+        return;
+    }
+    while (n > 0) {
+        int room = 8 - int(pos & 7);
+        int take = n < room ? n : room;
+        uint bits = uint(value >> (n - take)) & ((1u << take) - 1);
+        buf[pos >> 3] |= uchar(bits << (room - take));
+        pos += take;
+        n   -= take;
+    }
+}
+
+static inline quint64 getBits(const uchar *buf, quint32 &pos, int n)
+{
+    quint64 value = 0;
+    while (n > 0) {
+        int avail = 8 - int(pos & 7);
+        int take  = n < avail ? n : avail;
+        uint bits = (uint(buf[pos >> 3]) >> (avail - take)) & ((1u << take) - 1);
+        value = (value << take) | bits;
+        pos += take;
+        n   -= take;
+    }
+    return value;
+}
+
+static inline quint64 doubleBits(double v)
+{
+    quint64 bits;
+    std::memcpy(&bits, &v, sizeof(bits));
+    return bits;
+}
+
+static inline double bitsDouble(quint64 bits)
+{
+    double v;
+    std::memcpy(&v, &bits, sizeof(v));
+    return v;
+}
+
+// ================================================================
+//  Encoder
+// ================================================================
+
+static void encodeSample(uchar *buf, GorillaState &s, qint64 timestampMs, quint64 bits)
+{
+    if (s.count == 0) {
+        putBits(buf, s.bitPos, quint64(timestampMs), 64);
+        putBits(buf, s.bitPos, bits, 64);
+    } else {
+        // Timestamp: delta of delta
+        const qint64 delta = timestampMs - s.prevTime;
+        const qint64 dod   = delta - s.prevDelta;
+        if (dod == 0) {
+            putBits(buf, s.bitPos, 1, 1);
+        } else {
+            for (int b = 0; b < DOD_BUCKET_COUNT; b++) {
+                const DodBucket &bucket = DOD_BUCKETS[b];
+                if (fitsSigned(dod, bucket.valueBits)) {
+                    putBits(buf, s.bitPos, bucket.prefix, bucket.prefixBits);
+                    putBits(buf, s.bitPos, lowBits(quint64(dod), bucket.valueBits),
+                            bucket.valueBits);
+                    break;
+                }
+            }
+        }
+        s.prevDelta = delta;
+
+        // Value: XOR with the previous one
+        const quint64 x = bits ^ s.prevBits;
+        if (x == 0) {
+            putBits(buf, s.bitPos, 0, 1);
+        } else {
+            int leading  = qMin(31, int(qCountLeadingZeroBits(x)));
+            int trailing = int(qCountTrailingZeroBits(x));
+
+            if (s.prevLeading >= 0 && leading >= s.prevLeading && trailing >= s.prevTrailing) {
+                int length = 64 - s.prevLeading - s.prevTrailing;
+                putBits(buf, s.bitPos, 0x2, 2);
+                putBits(buf, s.bitPos, x >> s.prevTrailing, length);
+            } else {
+                int length = 64 - leading - trailing;
+                putBits(buf, s.bitPos, 0x3, 2);
+                putBits(buf, s.bitPos, quint64(leading), 5);
+                putBits(buf, s.bitPos, quint64(length & 63), 6);   // 64 stored as 0
+                putBits(buf, s.bitPos, x >> trailing, length);
+                s.prevLeading  = leading;
+                s.prevTrailing = trailing;
+            }
+        }
+    }
+
+    s.prevTime = timestampMs;
+    s.prevBits = bits;
+    s.count++;
+}
+
+bool GorillaCodec::append(uchar *stream, quint32 capacityBits, GorillaState &state,
+                          qint64 timestampMs, double value)
+{
+    const quint64 bits = doubleBits(value);
+
+    // Size it first, so a sample that doesn't fit leaves no trace
+    GorillaState probe = state;
+    encodeSample(nullptr, probe, timestampMs, bits);
+    if (probe.bitPos > capacityBits)
+        return false;
+
+    encodeSample(stream, state, timestampMs, bits);
+    return true;
+}
+
+// ================================================================
+//  Decoder
+// ================================================================
+
+bool GorillaDecoder::next(qint64 &timestampMs, double &value)
+{
+    // Every read is bounds-checked: a torn block may claim more
+    // samples than its bits hold
+    auto take = [this](int n, quint64 &out) {
+        if (st.bitPos + quint32(n) > capacityBits)
+            return false;
+        out = getBits(stream, st.bitPos, n);
+        return true;
+    };
+
+    quint64 v;
+
+    if (st.count == 0) {
+        quint64 t;
+        if (!take(64, t) || !take(64, v))
+            return false;
+        st.prevTime  = qint64(t);
+        st.prevDelta = 0;
+        st.prevBits  = v;
+    } else {
+        // Timestamp: '1', or up to five zeros naming the bucket
+        if (!take(1, v))
+            return false;
+
+        qint64 dod = 0;
+        if (v == 0) {
+            int zeros = 1;
+            while (zeros < 5) {
+                if (!take(1, v))
+                    return false;
+                if (v == 1)
+                    break;
+                zeros++;
+            }
+
+            const int width = DOD_BUCKETS[zeros - 1].valueBits;
+            if (!take(width, v))
+                return false;
+            dod = qint64(v);
+            if (width < 64 && (v >> (width - 1)) & 1)
+                dod -= qint64(1) << width;
+
+            // Never emitted: this is zero fill past the last sample
+            if (dod == 0)
+                return false;
+        }
+        st.prevDelta += dod;
+        st.prevTime  += st.prevDelta;
+
+        // Value
+        if (!take(1, v))
+            return false;
+        if (v != 0) {
+            quint64 window;
+            if (!take(1, window))
+                return false;
+
+            int leading, length;
+            if (window == 0) {
+                if (st.prevLeading < 0)
+                    return false;
+                leading = st.prevLeading;
+                length  = 64 - st.prevLeading - st.prevTrailing;
+            } else {
+                quint64 l, n;
+                if (!take(5, l) || !take(6, n))
+                    return false;
+                leading = int(l);
+                length  = n == 0 ? 64 : int(n);
+                if (leading + length > 64)
+                    return false;
+                st.prevLeading  = leading;
+                st.prevTrailing = 64 - leading - length;
+            }
+
+            quint64 meaningful;
+            if (!take(length, meaningful))
+                return false;
+            st.prevBits ^= meaningful << (64 - leading - length);
+        }
+    }
+
+    st.count++;
+    timestampMs = st.prevTime;
+    value       = bitsDouble(st.prevBits);
+    return true;
+}
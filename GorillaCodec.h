@@ -0,0 +1,73 @@
+/////////////////////////////////////////////////////////////
+// GORILLACODEC.H - Compressed Time-Series Block Codec
+/////////////////////////////////////////////////////////////
+
+#ifndef GORILLACODEC_H
+#define GORILLACODEC_H
+
+#include <QtGlobal>
+
+// Bit-stream codec for (timestamp, value) samples after the
+// scheme in Facebook's Gorilla paper, tuned for millisecond
+// timestamps:
+//
+//   first sample   64-bit timestamp, 64-bit IEEE value
+//   timestamp      delta-of-delta, by size:
+//                    '1'                       unchanged interval
+//                    '01'    +  7-bit dod      within ±64 ms
+//                    '001'   + 12-bit dod      within ±2 s
+//                    '0001'  + 20-bit dod      within ±8.7 min
+//                    '00001' + 32-bit dod
+//                    '00000' + 64-bit dod
+//   value          XOR with the previous value:
+//                    '0'                       same value
+//                    '10' + meaningful bits    fits the previous window
+//                    '11' + 5-bit leading zeros + 6-bit length
+//                         + meaningful bits    new window
+//
+// A steady sensor sampled at a steady rate costs a few bits per
+// sample. Samples are appended one at a time straight into a
+// zero-filled buffer, so a store can encode into a mapped block.
+// Zero fill never decodes as a sample (a zero dod is only ever
+// written as '1'), so the decoder stops where the writes stopped.
+struct GorillaState {
+    quint32 bitPos       = 0;    // Bits used so far
+    quint32 count        = 0;    // Samples encoded
+    qint64  prevTime     = 0;
+    qint64  prevDelta    = 0;
+    quint64 prevBits     = 0;    // Previous value, as IEEE bits
+    int     prevLeading  = -1;   // XOR window; -1 = none yet
+    int     prevTrailing = 0;
+};
+
+class GorillaCodec
+{
+public:
+    // Append a sample at state.bitPos. The buffer must be zero from
+    // there on. Returns false, touching nothing, if the sample
+    // would run past capacityBits.
+    static bool append(uchar *stream, quint32 capacityBits, GorillaState &state,
+                       qint64 timestampMs, double value);
+};
+
+// Sequential decoder; carries the same state as the encoder, so
+// decoding a block to its end also yields the state to resume
+// appending to it
+class GorillaDecoder
+{
+public:
+    GorillaDecoder(const uchar *stream, quint32 capacityBits)
+        : stream(stream), capacityBits(capacityBits) {}
+
+    // Next sample; false if the stream runs past capacityBits
+    bool next(qint64 &timestampMs, double &value);
+
+    const GorillaState &state() const { return st; }
+
+private:
+    const uchar *stream;
+    quint32 capacityBits;
+    GorillaState st;
+};
+
+#endif // GORILLACODEC_H
@@ -0,0 +1,302 @@
+/////////////////////////////////////////////////////////////
+// HISTORYEXPORTER.CPP - Bulk History Export
+/////////////////////////////////////////////////////////////
+
+#include "HistoryExporter.h"
+#include "SeriesQuery.h"
+#include <QDateTime>
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QStandardPaths>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+
+static const char   COLUMNAR_MAGIC[8] = { 'S', 'R', 'C', 'O', 'L', '0', '0', '1' };
+static const qint64 DAY_MS            = 24 * 3600 * 1000LL;
+
+// QString::SkipEmptyParts is deprecated from Qt 5.14
+#if QT_VERSION >= QT_VERSION_CHECK(5, 14, 0)
+static const auto SKIP_EMPTY_PARTS = Qt::SkipEmptyParts;
+#else
+static const auto SKIP_EMPTY_PARTS = QString::SkipEmptyParts;
+#endif
+
+// Sequential output through one large buffer: the file sees a few
+// big write() calls instead of one per row
+class BufferedOutput
+{
+public:
+    bool open(const QString &path, int capacity)
+    {
+        file.setFileName(path);
+        if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Unbuffered)) {
+            qWarning() << "HistoryExporter: cannot write" << path << file.errorString();
+            return false;
+        }
+        buf.reserve(capacity);
+        limit = capacity;
+        return true;
+    }
+
+    void write(const char *data, qint64 n)
+    {
+        if (buf.size() + n > limit)
+            flush();
+        if (n >= limit) {
+            if (file.write(data, n) != n)
+                failed = true;
+        } else {
+            buf.append(data, int(n));
+        }
+        pos += n;
+    }
+
+    bool close()
+    {
+        if (!file.isOpen())
+            return true;
+        flush();
+        file.close();
+        if (failed)
+            qWarning() << "HistoryExporter: write failed on" << file.fileName();
+        return !failed;
+    }
+
+    qint64 pos = 0;                 // Bytes written so far
+
+private:
+    QFile      file;
+    QByteArray buf;
+    int        limit  = 0;
+    bool       failed = false;
+
+    void flush()
+    {
+        if (buf.isEmpty())
+            return;
+        if (file.write(buf) != buf.size())
+            failed = true;
+        buf.resize(0);              // Keeps the reserved capacity
+    }
+};
+
+// yyyy-MM-ddTHH:mm:ss.zzzZ, calling gmtime only when the second changes
+class UtcFormatter
+{
+public:
+    const char *format(qint64 timestampMs)
+    {
+        const qint64 second = timestampMs >= 0 ? timestampMs / 1000 : (timestampMs - 999) / 1000;
+        if (second != cachedSecond) {
+            std::time_t t = static_cast<std::time_t>(second);
+            std::tm tmv;
+#ifdef Q_OS_WIN
+            gmtime_s(&tmv, &t);
+#else
+            gmtime_r(&t, &tmv);
+#endif
+            std::strftime(text, sizeof(text), "%Y-%m-%dT%H:%M:%S", &tmv);
+            cachedSecond = second;
+        }
+        const int millis = int(timestampMs - second * 1000);
+        text[19] = '.';
+        text[20] = char('0' + millis / 100);
+        text[21] = char('0' + millis / 10 % 10);
+        text[22] = char('0' + millis % 10);
+        text[23] = 'Z';
+        text[24] = '\0';
+        return text;
+    }
+
+private:
+    qint64 cachedSecond = -1;
+    char   text[32];
+};
+
+// A CSV field, quoted only when it has to be
+static QByteArray csvField(const QString &text)
+{
+    QByteArray field = text.toUtf8();
+    if (field.contains(',') || field.contains('"') || field.contains('\n'))
+        field = '"' + field.replace("\"", "\"\"") + '"';
+    return field;
+}
+
+HistoryExporter::HistoryExporter(const TimeSeriesStore &store)
+    : store(store)
+{
+}
+
+bool HistoryExporter::exportRange(const QString &basePath, const QStringList &series,
+                                  qint64 fromMs, qint64 toMs, int formats)
+{
+    QElapsedTimer timer;
+    timer.start();
+    rows = 0;
+
+    const bool columnar = formats & Columnar;
+    const bool csv      = formats & Csv;
+    BufferedOutput colOut, csvOut;
+    if ((columnar && !colOut.open(basePath + ".srcol", bufferBytes))
+        || (csv && !csvOut.open(basePath + ".csv", bufferBytes)))
+        return false;
+
+    if (columnar)
+        colOut.write(COLUMNAR_MAGIC, sizeof(COLUMNAR_MAGIC));
+    if (csv) {
+        static const char HEADER[] = "series,timestamp_ms,time_utc,value\n";
+        csvOut.write(HEADER, sizeof(HEADER) - 1);
+    }
+
+    const QStringList names = series.isEmpty() ? store.seriesNames() : series;
+    QByteArray seriesJson, groupsJson;
+    QVector<qint64> times;
+    QVector<double> values;
+    UtcFormatter utc;
+    char line[96];
+
+    for (int i = 0; i < names.size(); i++) {
+        seriesJson += QByteArray(i > 0 ? "," : "") + "\"" + names[i].toUtf8() + "\"";
+
+        const qint64 newest = store.lastTimestamp(names[i]);
+        if (newest == 0)
+            continue;
+        const qint64 first = qMax(fromMs, store.firstTimestamp(names[i]));
+        const qint64 last  = qMin(toMs, newest);
+        const QByteArray prefix = csvField(names[i]) + ',';
+
+        // One UTC day per chunk: bounded memory, one row group each
+        for (qint64 day = first - first % DAY_MS; day <= last; day += DAY_MS) {
+            const QVector<TimeSeriesSample> chunk =
+                store.read(names[i], qMax(first, day), qMin(last, day + DAY_MS - 1));
+            const int n = chunk.size();
+            if (n == 0)
+                continue;
+            rows += n;
+
+            if (columnar) {
+                times.resize(n);
+                values.resize(n);
+                for (int k = 0; k < n; k++) {
+                    times[k]  = chunk[k].timestampMs;
+                    values[k] = chunk[k].value;
+                }
+
+                const qint64 at = colOut.pos;
+                groupsJson += QByteArray(groupsJson.isEmpty() ? "" : ",")
+                              + "{\"series\":" + QByteArray::number(i)
+                              + ",\"rows\":" + QByteArray::number(n)
+                              + ",\"timestamps\":" + QByteArray::number(at)
+                              + ",\"values\":" + QByteArray::number(at + qint64(n) * 8)
+                              + ",\"firstMs\":" + QByteArray::number(times.first())
+                              + ",\"lastMs\":" + QByteArray::number(times.last()) + "}";
+                colOut.write(reinterpret_cast<const char *>(times.constData()), qint64(n) * 8);
+                colOut.write(reinterpret_cast<const char *>(values.constData()), qint64(n) * 8);
+            }
+
+            if (csv) {
+                for (const TimeSeriesSample &sample : chunk) {
+                    const int len = std::snprintf(line, sizeof(line), "%lld,%s,%.15g\n",
+                                                  static_cast<long long>(sample.timestampMs),
+                                                  utc.format(sample.timestampMs), sample.value);
+                    csvOut.write(prefix.constData(), prefix.size());
+                    csvOut.write(line, len);
+                }
+            }
+        }
+    }
+
+    if (columnar) {
+        const QByteArray footer = "{\"version\":1,\"byteOrder\":\""
+                                  + QByteArray(Q_BYTE_ORDER == Q_LITTLE_ENDIAN ? "little" : "big")
+                                  + "\",\"series\":[" + seriesJson
+                                  + "],\"rowGroups\":[" + groupsJson + "]}";
+        const quint32 length = quint32(footer.size());
+        uchar le[4] = { uchar(length), uchar(length >> 8), uchar(length >> 16), uchar(length >> 24) };
+        colOut.write(footer.constData(), footer.size());
+        colOut.write(reinterpret_cast<const char *>(le), 4);
+        colOut.write(COLUMNAR_MAGIC, sizeof(COLUMNAR_MAGIC));
+    }
+
+    const bool colOk = colOut.close();
+    const bool csvOk = csvOut.close();
+    bytes   = colOut.pos + csvOut.pos;
+    elapsed = timer.elapsed();
+
+    qDebug() << "HistoryExporter:" << rows << "rows," << bytes / 1024 << "KiB in"
+             << elapsed << "ms";
+    return colOk && csvOk;
+}
+
+// ================================================================
+//  Command Line
+// ================================================================
+
+// Absolute ms, or a duration relative to now when not positive
+static bool parseTime(const char *text, qint64 &ms)
+{
+    if (!SeriesQuery::parseDuration(QString::fromUtf8(text), ms))
+        return false;
+    if (ms <= 0)
+        ms += QDateTime::currentMSecsSinceEpoch();
+    return true;
+}
+
+int exportHistory(int argc, char *argv[])
+{
+    if (argc < 3) {
+        std::fprintf(stderr, "usage: %s --export <base> [--series a,b] [--from T] [--to T]"
+                             " [--format csv|columnar|both]\n", argv[0]);
+        return 2;
+    }
+
+    const QString basePath = QString::fromLocal8Bit(argv[2]);
+    QStringList series;
+    qint64 fromMs = 0;
+    qint64 toMs   = QDateTime::currentMSecsSinceEpoch();
+    int formats   = HistoryExporter::Columnar | HistoryExporter::Csv;
+
+    for (int i = 3; i < argc; i += 2) {
+        const char *option = argv[i];
+        const char *value  = i + 1 < argc ? argv[i + 1] : nullptr;   // Missing: a usage error
+        bool ok = true;
+        if (!value)
+            ok = false;
+        else if (std::strcmp(option, "--series") == 0)
+            series = QString::fromUtf8(value).split(',', SKIP_EMPTY_PARTS);
+        else if (std::strcmp(option, "--from") == 0)
+            ok = parseTime(value, fromMs);
+        else if (std::strcmp(option, "--to") == 0)
+            ok = parseTime(value, toMs);
+        else if (std::strcmp(option, "--format") == 0) {
+            if (std::strcmp(value, "csv") == 0)           formats = HistoryExporter::Csv;
+            else if (std::strcmp(value, "columnar") == 0) formats = HistoryExporter::Columnar;
+            else if (std::strcmp(value, "both") != 0)     ok = false;
+        } else
+            ok = false;
+
+        if (!ok) {
+            std::fprintf(stderr, "export: bad option %s %s\n", option, value ? value : "");
+            return 2;
+        }
+    }
+
+    // Read-only: safe to run while the controller is appending
+    TimeSeriesStore store(QStandardPaths::writableLocation(QStandardPaths::AppDataLocation)
+                          + "/history");
+    if (!store.open(TimeSeriesStore::ReadOnly))
+        return 1;
+
+    HistoryExporter exporter(store);
+    if (!exporter.exportRange(basePath, series, fromMs, toMs, formats))
+        return 1;
+
+    const double seconds = qMax<qint64>(exporter.elapsedMs(), 1) / 1000.0;
+    std::printf("Exported %lld rows (%.1f MiB) in %.2f s, %.1f MiB/s\n",
+                static_cast<long long>(exporter.rowsWritten()),
+                exporter.bytesWritten() / 1048576.0, seconds,
+                exporter.bytesWritten() / 1048576.0 / seconds);
+    return 0;
+}
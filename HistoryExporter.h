@@ -0,0 +1,67 @@
+/////////////////////////////////////////////////////////////
+// HISTORYEXPORTER.H - Bulk History Export Header
+/////////////////////////////////////////////////////////////
+
+#ifndef HISTORYEXPORTER_H
+#define HISTORYEXPORTER_H
+
+#include <QStringList>
+
+#include "TimeSeriesStore.h"
+
+// Streams stored series to files for offline analysis, one day of
+// one series at a time, through large sequential writes.
+//
+// <base>.csv    series,timestamp_ms,time_utc,value
+//
+// <base>.srcol  columnar, laid out like a minimal Parquet file:
+//   "SRCOL001"                                   8-byte magic
+//   row groups, one per series-day:
+//     int64 timestamps (ms since epoch) × rows
+//     float64 values × rows
+//   footer JSON: {"version":1,"byteOrder":"little"|"big",
+//     "series":[…],"rowGroups":[{"series":i,"rows":n,
+//     "timestamps":offset,"values":offset,"firstMs":…,"lastMs":…},…]}
+//   uint32 footer length (little-endian), "SRCOL001"
+//
+// Columns are written straight from memory in the host's byte order
+// (named in the footer) and start 8-byte aligned, so numpy can map
+// them directly:
+//   n = struct.unpack('<I', data[-12:-8])[0]
+//   footer = json.loads(data[-12 - n:-12])
+//   ts = np.frombuffer(data, '<i8', g['rows'], g['timestamps'])
+class HistoryExporter
+{
+public:
+    enum Format {
+        Columnar = 0x1,
+        Csv      = 0x2
+    };
+
+    explicit HistoryExporter(const TimeSeriesStore &store);
+
+    // Export 'series' (every stored series if empty) over
+    // [fromMs, toMs] to <basePath>.srcol and/or <basePath>.csv
+    bool exportRange(const QString &basePath, const QStringList &series,
+                     qint64 fromMs, qint64 toMs, int formats = Columnar | Csv);
+
+    qint64 rowsWritten()  const { return rows; }
+    qint64 bytesWritten() const { return bytes; }
+    qint64 elapsedMs()    const { return elapsed; }
+
+    int bufferBytes = 4 * 1024 * 1024;    // Per output file
+
+private:
+    const TimeSeriesStore &store;
+    qint64 rows    = 0;
+    qint64 bytes   = 0;
+    qint64 elapsed = 0;
+};
+
+// --export <base> [--series a,b] [--from T] [--to T] [--format F]
+// against the controller's history, opened read-only. T is ms since
+// the epoch, or a duration back from now ("-30d", "0" = now); F is
+// csv, columnar or both. Returns the process exit code.
+int exportHistory(int argc, char *argv[]);
+
+#endif // HISTORYEXPORTER_H
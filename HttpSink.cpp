@@ -0,0 +1,393 @@
+/////////////////////////////////////////////////////////////
+// HTTPSINK.CPP - HTTP Upload Sink Implementation
+/////////////////////////////////////////////////////////////
+
+#include "HttpSink.h"
+#include <QRandomGenerator>
+
+// Rough HTTP request/response header cost, charged to the byte
+// budget on top of the body
+static const int REQUEST_OVERHEAD_BYTES = 300;
+
+// Share of the daily budget each lane leaves untouched for the
+// lanes above it
+static const double LANE_RESERVE[UPLOAD_PRIORITY_COUNT] = {
+    0.0,    // Safety   — may use everything
+    0.1,    // Live
+    0.3,    // Forecast
+    0.5     // Backfill
+};
+
+HttpSink::HttpSink(const QString &name, const QUrl &url, const QString &queuePath,
+                   QObject *parent)
+    : TelemetrySink(name, parent)
+    , apiUrl(url)
+{
+    manager = new QNetworkAccessManager(this);
+    clock.start();
+
+    // Durable queue: every reading is logged before it is sent,
+    // and stays in the log until the server acknowledges it
+    queue = new UploadQueue(queuePath, this);
+    queue->open();
+
+    backfillTimer = new QTimer(this);
+    connect(backfillTimer, &QTimer::timeout, this, &HttpSink::drainBacklog);
+    backfillTimer->start(backfillIntervalMs);
+
+    budgetTimer = new QTimer(this);
+    budgetTimer->setSingleShot(true);
+    connect(budgetTimer, &QTimer::timeout, this, &HttpSink::flushOutbox);
+
+    breakerTimer = new QTimer(this);
+    breakerTimer->setSingleShot(true);
+    connect(breakerTimer, &QTimer::timeout, this, &HttpSink::onBreakerCooldown);
+}
+
+void HttpSink::submit(const SensorReading &submitted)
+{
+    // Log first, then send. Under backpressure forecast and backfill
+    // readings only go to disk and drainBacklog() picks them up
+    // later; valve events and live readings are still posted, but
+    // only the newest per sensor stays in memory.
+    SensorReading reading = submitted;
+    queue->append(reading);
+    stats.readingsSubmitted++;
+    if (queuedReadings() < maxQueuedReadings)
+        postReading(reading);
+    else if (reading.priority <= UploadPriority::Live)
+        postNewest(reading);
+    else
+        stats.deferred++;
+
+    updateBackpressure();
+}
+
+SinkMetrics HttpSink::metrics() const
+{
+    SinkMetrics m;
+    m.name              = name();
+    m.type              = type();
+    m.latency           = stats.latency;
+    m.readingsSubmitted = stats.readingsSubmitted;
+    m.readingsDelivered = stats.readingsDelivered;
+    m.readingsDropped   = stats.rejected;
+    m.bytesSent         = stats.bytesSent;
+    m.requests          = stats.requestsSent;
+    m.failures          = stats.requestsFailed;
+    m.retries           = stats.retries;
+    m.timeouts          = stats.timeouts;
+    m.breakerTrips      = stats.breakerTrips;
+    m.inFlight          = inFlightRequests;
+    m.queueDepth        = queuedReadings();
+    m.backlog           = queue->pendingCount();
+    m.breaker           = breaker == BreakerState::Closed ? "closed"
+                        : breaker == BreakerState::Open   ? "open"
+                                                          : "half-open";
+    return m;
+}
+
+void HttpSink::setDailyBudget(qint64 bytes, int requests)
+{
+    const qint64 day = 24LL * 3600 * 1000;
+    byteBudget.configure(bytes, day);
+    requestBudget.configure(requests, day);
+}
+
+// Internal: charge one request to the daily budget, honouring the
+// lane's reserve. Returns false if the lane has to wait.
+bool HttpSink::spendBudget(UploadPriority lane, int bytes)
+{
+    qint64 now = QDateTime::currentMSecsSinceEpoch();
+    double reserve = LANE_RESERVE[static_cast<int>(lane)];
+    double cost = bytes + REQUEST_OVERHEAD_BYTES;
+
+    if (!byteBudget.canSpend(cost, reserve, now)
+        || !requestBudget.canSpend(1, reserve, now))
+        return false;
+
+    byteBudget.spend(cost);
+    requestBudget.spend(1);
+    return true;
+}
+
+// Internal: queue a reading on its lane for the next outbox flush
+void HttpSink::postReading(const SensorReading &reading)
+{
+    lanes[static_cast<int>(reading.priority)].append(reading);
+    claimed.insert(reading.seq);
+    scheduleFlush();
+}
+
+// Internal: post a reading in place of the newest one queued for
+// the same sensor on its lane, which is left to the WAL. Keeps the
+// lanes bounded while the breaker holds them back.
+void HttpSink::postNewest(const SensorReading &reading)
+{
+    QVector<SensorReading> &lane = lanes[static_cast<int>(reading.priority)];
+    for (int i = lane.size() - 1; i >= 0; i--) {
+        if (lane[i].sensorId == reading.sensorId) {
+            claimed.remove(lane[i].seq);
+            claimed.insert(reading.seq);
+            lane[i] = reading;
+            stats.deferred++;
+            scheduleFlush();
+            return;
+        }
+    }
+    postReading(reading);
+}
+
+void HttpSink::scheduleFlush()
+{
+    if (!flushScheduled) {
+        flushScheduled = true;
+        QTimer::singleShot(0, this, &HttpSink::flushOutbox);
+    }
+}
+
+int HttpSink::queuedReadings() const
+{
+    int total = 0;
+    for (const auto &lane : lanes)
+        total += lane.size();
+    return total;
+}
+
+void HttpSink::updateBackpressure()
+{
+    bool active = queuedReadings() >= maxQueuedReadings;
+    if (active != backpressured) {
+        backpressured = active;
+        emit backpressureChanged(active);
+    }
+}
+
+// Encode and POST the lanes in priority order. A lower lane is
+// only reached once every lane above it has been sent; whatever
+// the window, breaker or budget holds back stays queued.
+void HttpSink::flushOutbox()
+{
+    flushScheduled = false;
+
+    if (breaker == BreakerState::Open)
+        return;
+
+    // A half-open breaker lets exactly one probe through
+    int window = breaker == BreakerState::HalfOpen ? 1 : maxInFlight;
+
+    for (int l = 0; l < UPLOAD_PRIORITY_COUNT; l++) {
+        QVector<SensorReading> &lane = lanes[l];
+        UploadPriority priority = static_cast<UploadPriority>(l);
+
+        while (!lane.isEmpty()) {
+            if (inFlightRequests >= window)
+                return;   // Resumed from onReplyFinished()
+
+            bool cbor = wireFormat != WireFormat::Json;
+            int take = cbor ? qMin(maxBatchReadings, lane.size()) : 1;
+            QVector<SensorReading> batch = lane.mid(0, take);
+
+            QByteArray body = cbor ? WireCodec::deflate(WireCodec::toCbor(batch))
+                                   : WireCodec::toJson(batch.first());
+
+            if (!spendBudget(priority, body.size())) {
+                // Lower lanes have larger reserves, so they'd be
+                // refused too — wait for the bucket to refill
+                if (!budgetTimer->isActive())
+                    budgetTimer->start(60 * 1000);
+                return;
+            }
+
+            int attempt = 0;
+            for (const SensorReading &reading : batch)
+                attempt = qMax(attempt, reading.attempt);
+
+            postBody(body, cbor, batch, attempt);
+            lane.remove(0, take);
+        }
+    }
+
+    updateBackpressure();
+}
+
+// Internal: POST an encoded body to the API
+void HttpSink::postBody(const QByteArray &body, bool cbor,
+                              const QVector<SensorReading> &batch, int attempt)
+{
+    QNetworkRequest request(apiUrl);
+    if (cbor) {
+        request.setHeader(QNetworkRequest::ContentTypeHeader, "application/cbor");
+        request.setRawHeader("Content-Encoding", "deflate");
+    } else {
+        request.setHeader(QNetworkRequest::ContentTypeHeader, "application/json");
+        request.setRawHeader("Idempotency-Key", batch.first().key);
+    }
+
+    inFlightRequests++;
+    stats.requestsSent++;
+    stats.bytesSent += body.size();
+
+    qint64 started = clock.elapsed();
+    QNetworkReply *reply = manager->post(request, body);
+    connect(reply, &QNetworkReply::finished, this,
+            [this, reply, batch, attempt, cbor, started]() {
+        stats.latency.record(clock.elapsed() - started);
+        onReplyFinished(reply, batch, attempt, cbor);
+    });
+
+    // Abort requests that hang; the timer dies with the reply
+    QTimer::singleShot(requestTimeoutMs, reply, [reply]() {
+        reply->setProperty("timedOut", true);
+        reply->abort();
+    });
+}
+
+// Handle API response
+void HttpSink::onReplyFinished(QNetworkReply *reply,
+                                     const QVector<SensorReading> &batch,
+                                     int attempt, bool cbor)
+{
+    inFlightRequests--;
+
+    int status = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+
+    if (reply->error() == QNetworkReply::NoError) {
+        stats.requestsSucceeded++;
+        stats.readingsDelivered += batch.size();
+        for (const SensorReading &reading : batch)
+            queue->ack(reading.seq);
+        unclaim(batch);
+        recordSuccess();
+    } else if (cbor && status == 415 && wireFormat == WireFormat::Auto) {
+        // Server doesn't accept CBOR: fall back to JSON and send
+        // the same readings again
+        qWarning() << "DB server does not accept CBOR, falling back to JSON";
+        wireFormat = WireFormat::Json;
+        for (const SensorReading &reading : batch)
+            postReading(reading);
+    } else if (status >= 400 && status < 500 && status != 408 && status != 429) {
+        // The server rejected these readings outright; replaying
+        // them would only fail again, so drop them from the queue.
+        qWarning() << "DB rejected" << batch.size() << "reading(s) (HTTP"
+                   << status << "), dropping";
+        stats.rejected += batch.size();
+        for (const SensorReading &reading : batch)
+            queue->ack(reading.seq);
+        unclaim(batch);
+    } else {
+        // Retryable: network error, timeout, 5xx, 408 or 429
+        stats.requestsFailed++;
+        if (reply->property("timedOut").toBool())
+            stats.timeouts++;
+        recordFailure(reply->errorString());
+
+        if (attempt < maxRetries) {
+            scheduleRetry(batch, attempt + 1);
+        } else {
+            // Still on disk — the backlog drain takes over
+            stats.retriesExhausted++;
+            unclaim(batch);
+        }
+    }
+
+    reply->deleteLater();
+    scheduleFlush();
+}
+
+// Put a failed batch back on its lanes after an exponential,
+// jittered delay
+void HttpSink::scheduleRetry(const QVector<SensorReading> &batch, int attempt)
+{
+    stats.retries++;
+
+    int ceiling = int(qMin<qint64>(retryMaxMs, qint64(retryBaseMs) << qMin(attempt, 20)));
+    int delay = ceiling / 2 + QRandomGenerator::global()->bounded(ceiling / 2 + 1);
+
+    QTimer::singleShot(delay, this, [this, batch, attempt]() {
+        for (SensorReading reading : batch) {
+            reading.attempt = attempt;
+            postReading(reading);
+        }
+    });
+}
+
+// Release readings so drainBacklog() may pick them up again
+void HttpSink::unclaim(const QVector<SensorReading> &batch)
+{
+    for (const SensorReading &reading : batch)
+        claimed.remove(reading.seq);
+}
+
+// ================================================================
+//  Circuit breaker
+// ================================================================
+
+void HttpSink::recordSuccess()
+{
+    if (breaker != BreakerState::Closed) {
+        qDebug() << "DB uplink restored," << queue->pendingCount()
+                 << "readings queued for backfill";
+        breaker = BreakerState::Closed;
+        currentCooldownMs = 0;
+    }
+    consecutiveFailures = 0;
+}
+
+void HttpSink::recordFailure(const QString &error)
+{
+    consecutiveFailures++;
+    if (consecutiveFailures <= 3) {
+        qWarning() << "DB write failed:" << error;
+    }
+    if (consecutiveFailures == 3) {
+        qWarning() << "Suppressing further DB error messages...";
+    }
+
+    bool trip = breaker == BreakerState::HalfOpen
+                || (breaker == BreakerState::Closed
+                    && consecutiveFailures >= breakerThreshold);
+    if (!trip)
+        return;
+
+    // First trip uses the base cooldown; each failed probe doubles it
+    currentCooldownMs = breaker == BreakerState::HalfOpen
+                            ? qMin(currentCooldownMs * 2, breakerMaxCooldownMs)
+                            : breakerCooldownMs;
+    breaker = BreakerState::Open;
+    stats.breakerTrips++;
+    breakerTimer->start(currentCooldownMs);
+}
+
+void HttpSink::onBreakerCooldown()
+{
+    breaker = BreakerState::HalfOpen;
+
+    // Probe with whatever is waiting, or one reading from the backlog
+    if (queuedReadings() == 0)
+        drainBacklog();
+    scheduleFlush();
+}
+
+// Replay queued readings from disk on the lanes they were logged
+// with: a small batch per interval while healthy and the outbox is
+// nearly empty, a single probe while the breaker is half-open,
+// nothing while it is open.
+void HttpSink::drainBacklog()
+{
+    int batch;
+    if (breaker == BreakerState::Closed)
+        batch = backfillBatch - queuedReadings();
+    else if (breaker == BreakerState::HalfOpen && inFlightRequests == 0
+             && queuedReadings() == 0)
+        batch = 1;
+    else
+        return;
+
+    if (batch <= 0 || queuedReadings() >= maxQueuedReadings)
+        return;
+
+    const QVector<SensorReading> backlog = queue->pending(batch, claimed);
+    for (const SensorReading &reading : backlog)
+        postReading(reading);
+}
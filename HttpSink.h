@@ -0,0 +1,165 @@
+/////////////////////////////////////////////////////////////
+// HTTPSINK.H - HTTP Upload Sink Class Header
+/////////////////////////////////////////////////////////////
+
+#ifndef HTTPSINK_H
+#define HTTPSINK_H
+
+#include <QNetworkAccessManager>
+#include <QNetworkRequest>
+#include <QNetworkReply>
+#include <QUrl>
+#include <QDebug>
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <QSet>
+#include <QTimer>
+
+#include "TelemetrySink.h"
+#include "UploadQueue.h"
+#include "WireCodec.h"
+#include "TokenBucket.h"
+
+// Body encoding for uploads (see WireCodec.h)
+enum class WireFormat {
+    Json,   // One JSON object per request (original API)
+    Cbor,   // Deflated CBOR batches
+    Auto    // CBOR, falling back to JSON if the server answers 415
+};
+
+// Circuit breaker protecting a down server from retry storms
+enum class BreakerState {
+    Closed,     // Normal operation
+    Open,       // Too many failures — nothing is sent until cooldown ends
+    HalfOpen    // Cooldown over — one probe request decides
+};
+
+// Running totals for the upload pipeline
+struct UploadCounters {
+    quint64 readingsSubmitted = 0;
+    quint64 readingsDelivered = 0;   // Acknowledged by the server
+    quint64 bytesSent         = 0;   // Request bodies, retries included
+    quint64 requestsSent      = 0;
+    quint64 requestsSucceeded = 0;
+    quint64 requestsFailed    = 0;   // Network errors, 5xx, timeouts
+    quint64 timeouts          = 0;
+    quint64 retries           = 0;   // Batches rescheduled after backoff
+    quint64 retriesExhausted  = 0;   // Batches left to the backlog drain
+    quint64 rejected          = 0;   // Readings dropped on a 4xx
+    quint64 deferred          = 0;   // Readings left on disk by backpressure
+    quint64 breakerTrips      = 0;
+    LatencyHistogram latency;        // Request start to reply
+};
+
+// Uploads readings to the HTTP API through a durable queue, with
+// priority lanes, a bandwidth budget, retries and a circuit breaker
+class HttpSink : public TelemetrySink
+{
+    Q_OBJECT
+
+public:
+    HttpSink(const QString &name, const QUrl &url, const QString &queuePath,
+             QObject *parent = nullptr);
+
+    QString type() const override { return "http"; }
+    void submit(const SensorReading &reading) override;
+    SinkMetrics metrics() const override;
+
+    // Backfill tuning: after an outage the queued backlog is
+    // replayed in small batches so live uploads keep flowing.
+    int backfillIntervalMs = 2000;   // Time between backlog drains
+    int backfillBatch      = 5;      // Max replays per drain
+
+    // Wire format tuning
+    WireFormat wireFormat  = WireFormat::Auto;
+    int maxBatchReadings   = 256;    // Readings per CBOR request
+
+    // Daily data budget for capped plans (0 = unlimited). Each
+    // lane keeps a reserve so bulk traffic stops while there is
+    // still headroom left for the lanes above it.
+    void setDailyBudget(qint64 bytes, int requests);
+
+    // Flow control. At most maxInFlight requests are outstanding;
+    // once maxQueuedReadings are waiting in memory, new forecast and
+    // backfill readings stay on disk only, valve events and live
+    // readings replace the newest queued one for their sensor, and
+    // backpressureChanged(true) is emitted.
+    int maxInFlight        = 4;
+    int maxQueuedReadings  = 2000;
+    int requestTimeoutMs   = 15000;
+
+    // Retry with exponential backoff and jitter: attempt n waits a
+    // random delay in [d/2, d] with d = min(base * 2^n, max)
+    int retryBaseMs        = 1000;
+    int retryMaxMs         = 5 * 60 * 1000;
+    int maxRetries         = 5;      // Then left to the backlog drain
+
+    // Circuit breaker: opens after this many consecutive failures;
+    // the cooldown doubles on every failed probe up to the max
+    int breakerThreshold     = 5;
+    int breakerCooldownMs    = 30 * 1000;
+    int breakerMaxCooldownMs = 15 * 60 * 1000;
+
+    bool isBackpressured() const { return backpressured; }
+    BreakerState breakerState() const { return breaker; }
+    const UploadCounters &counters() const { return stats; }
+
+signals:
+    void backpressureChanged(bool active);
+
+private slots:
+    void drainBacklog();
+    void flushOutbox();
+    void onBreakerCooldown();
+
+private:
+    QNetworkAccessManager *manager;
+    QUrl apiUrl;
+    QElapsedTimer clock;             // Monotonic time base for request latency
+
+    // ── Store-and-forward ──────────────────────────────────
+    UploadQueue   *queue;
+    QTimer        *backfillTimer;
+    QSet<quint64>  claimed;          // Queued readings in a lane, request or retry
+
+    // ── Outgoing requests ──────────────────────────────────
+    // Readings submitted within one event-loop turn are collected
+    // per priority lane and flushed together, so CBOR can batch
+    // them and higher lanes always go out first
+    QVector<SensorReading> lanes[UPLOAD_PRIORITY_COUNT];
+    bool flushScheduled   = false;
+    int  inFlightRequests = 0;
+    bool backpressured    = false;
+
+    int  queuedReadings() const;
+    void updateBackpressure();
+    void scheduleFlush();
+
+    // ── Bandwidth budget ───────────────────────────────────
+    TokenBucket byteBudget;
+    TokenBucket requestBudget;
+    QTimer     *budgetTimer;         // Retries lanes held back by the budget
+
+    bool spendBudget(UploadPriority lane, int bytes);
+    void postReading(const SensorReading &reading);
+    void postNewest(const SensorReading &reading);
+    void postBody(const QByteArray &body, bool cbor,
+                  const QVector<SensorReading> &batch, int attempt);
+    void onReplyFinished(QNetworkReply *reply, const QVector<SensorReading> &batch,
+                         int attempt, bool cbor);
+
+    // ── Retry / circuit breaker ────────────────────────────
+    BreakerState breaker = BreakerState::Closed;
+    QTimer *breakerTimer;
+    int consecutiveFailures = 0;
+    int currentCooldownMs   = 0;
+
+    void scheduleRetry(const QVector<SensorReading> &batch, int attempt);
+    void unclaim(const QVector<SensorReading> &batch);
+    void recordSuccess();
+    void recordFailure(const QString &error);
+
+    UploadCounters stats;
+};
+
+#endif // HTTPSINK_H
@@ -0,0 +1,99 @@
+/////////////////////////////////////////////////////////////
+// LOCALHTTPSERVER.CPP - Minimal Read-Only HTTP Endpoint
+/////////////////////////////////////////////////////////////
+
+#include "LocalHttpServer.h"
+#include <QDebug>
+#include <QTimer>
+#include <QUrl>
+
+LocalHttpServer::LocalHttpServer(QObject *parent)
+    : QObject(parent)
+{
+    server = new QTcpServer(this);
+    connect(server, &QTcpServer::newConnection,
+            this, &LocalHttpServer::onNewConnection);
+}
+
+bool LocalHttpServer::listen(const QHostAddress &address, quint16 port)
+{
+    if (!server->listen(address, port)) {
+        qWarning() << "LocalHttpServer: cannot listen on port" << port
+                   << server->errorString();
+        return false;
+    }
+    return true;
+}
+
+void LocalHttpServer::route(const QString &path, const Handler &handler)
+{
+    routes.insert(path, handler);
+}
+
+void LocalHttpServer::onNewConnection()
+{
+    while (QTcpSocket *socket = server->nextPendingConnection()) {
+        connect(socket, &QTcpSocket::disconnected, socket, &QObject::deleteLater);
+        connect(socket, &QTcpSocket::readyRead, this, [this, socket]() {
+            handleRequest(socket);
+        });
+
+        // Don't let idle clients hold a connection open
+        QTimer::singleShot(10 * 1000, socket, [socket]() { socket->abort(); });
+    }
+}
+
+// Wait for the full header block, then answer and close
+void LocalHttpServer::handleRequest(QTcpSocket *socket)
+{
+    if (socket->property("answered").toBool())
+        return;
+
+    QByteArray head = socket->peek(MAX_REQUEST_BYTES);
+    int end = head.indexOf("\r\n\r\n");
+    if (end < 0) {
+        if (head.size() >= MAX_REQUEST_BYTES)
+            socket->abort();
+        return;
+    }
+    socket->setProperty("answered", true);
+
+    QList<QByteArray> requestLine = head.left(head.indexOf("\r\n")).split(' ');
+    Response response;
+
+    if (requestLine.size() < 2) {
+        response.status = 400;
+        response.body = "Bad request\n";
+    } else if (requestLine[0] != "GET") {
+        response.status = 405;
+        response.body = "Only GET is supported\n";
+    } else {
+        QUrl url(QString::fromLatin1(requestLine[1]));
+        auto it = routes.constFind(url.path());
+        if (it == routes.constEnd()) {
+            response.status = 404;
+            response.body = "Not found\n";
+        } else {
+            response = it.value()(QUrlQuery(url));
+        }
+    }
+
+    respond(socket, response);
+}
+
+void LocalHttpServer::respond(QTcpSocket *socket, const Response &response)
+{
+    const char *reason = response.status == 200 ? "OK"
+                       : response.status == 400 ? "Bad Request"
+                       : response.status == 404 ? "Not Found"
+                       : response.status == 405 ? "Method Not Allowed"
+                       : "Error";
+
+    QByteArray header = "HTTP/1.0 " + QByteArray::number(response.status) + ' ' + reason
+                      + "\r\nContent-Type: " + response.contentType
+                      + "\r\nContent-Length: " + QByteArray::number(response.body.size())
+                      + "\r\nConnection: close\r\n\r\n";
+    socket->write(header);
+    socket->write(response.body);
+    socket->disconnectFromHost();
+}
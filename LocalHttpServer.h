@@ -0,0 +1,49 @@
+/////////////////////////////////////////////////////////////
+// LOCALHTTPSERVER.H - Minimal Read-Only HTTP Endpoint
+/////////////////////////////////////////////////////////////
+
+#ifndef LOCALHTTPSERVER_H
+#define LOCALHTTPSERVER_H
+
+#include <QByteArray>
+#include <QHash>
+#include <QHostAddress>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QUrlQuery>
+#include <functional>
+
+// Just enough HTTP/1.0 to answer GET requests from curl, a browser
+// or a Prometheus scraper. One request per connection; handlers
+// run on the thread that owns the server.
+class LocalHttpServer : public QObject
+{
+    Q_OBJECT
+
+public:
+    struct Response {
+        int        status = 200;
+        QByteArray contentType = "text/plain; charset=utf-8";
+        QByteArray body;
+    };
+    typedef std::function<Response(const QUrlQuery &query)> Handler;
+
+    explicit LocalHttpServer(QObject *parent = nullptr);
+
+    bool listen(const QHostAddress &address, quint16 port);
+    void route(const QString &path, const Handler &handler);
+
+private slots:
+    void onNewConnection();
+
+private:
+    QTcpServer *server;
+    QHash<QString, Handler> routes;
+
+    static const int MAX_REQUEST_BYTES = 8 * 1024;
+
+    void handleRequest(QTcpSocket *socket);
+    static void respond(QTcpSocket *socket, const Response &response);
+};
+
+#endif // LOCALHTTPSERVER_H
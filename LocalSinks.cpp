@@ -0,0 +1,110 @@
+/////////////////////////////////////////////////////////////
+// LOCALSINKS.CPP - File, Socket and Stdout Telemetry Sinks
+/////////////////////////////////////////////////////////////
+
+#include "LocalSinks.h"
+#include <QDebug>
+#include <QDir>
+#include <QFileInfo>
+#include <cstdio>
+
+// Encode a batch as NDJSON lines into the sink's reusable buffer
+static const QByteArray &toNdjson(ReadingSerializer &serializer,
+                                  const QVector<SensorReading> &batch)
+{
+    serializer.clear();
+    for (const SensorReading &reading : batch)
+        serializer.appendNdjson(reading);
+    return serializer.bytes();
+}
+
+// ================================================================
+//  FileSink
+// ================================================================
+
+FileSink::FileSink(const QString &name, const QString &path, QObject *parent)
+    : BufferedSink(name, parent)
+    , file(path)
+{
+}
+
+int FileSink::writeBatch(const QVector<SensorReading> &batch)
+{
+    if (!file.isOpen()) {
+        QDir().mkpath(QFileInfo(file.fileName()).absolutePath());
+        if (!file.open(QIODevice::WriteOnly | QIODevice::Append)) {
+            qWarning() << "FileSink: cannot open" << file.fileName() << file.errorString();
+            return 0;
+        }
+    }
+
+    if (file.write(toNdjson(serializer, batch)) < 0 || !file.flush()) {
+        qWarning() << "FileSink: write failed:" << file.errorString();
+        file.close();
+        return 0;
+    }
+    return batch.size();
+}
+
+// ================================================================
+//  UnixSocketSink
+// ================================================================
+
+UnixSocketSink::UnixSocketSink(const QString &name, const QString &path, QObject *parent)
+    : BufferedSink(name, parent)
+    , path(path)
+{
+    socket = new QLocalSocket(this);
+    connect(socket, &QLocalSocket::connected, this, &BufferedSink::flush);
+}
+
+int UnixSocketSink::writeBatch(const QVector<SensorReading> &batch)
+{
+    if (socket->state() == QLocalSocket::UnconnectedState)
+        socket->connectToServer(path, QIODevice::WriteOnly);
+
+    // Not connected yet, or the reader is falling behind: keep the
+    // readings queued and try again later
+    if (socket->state() != QLocalSocket::ConnectedState
+        || socket->bytesToWrite() > MAX_UNSENT_BYTES)
+        return 0;
+
+    socket->write(toNdjson(serializer, batch));
+    return batch.size();
+}
+
+// No event loop runs after this, so connect and write synchronously
+void UnixSocketSink::drain()
+{
+    if (socket->state() == QLocalSocket::UnconnectedState)
+        socket->connectToServer(path, QIODevice::WriteOnly);
+    if (socket->state() == QLocalSocket::ConnectingState)
+        socket->waitForConnected(DRAIN_TIMEOUT_MS);
+
+    auto writeOut = [this]() {
+        while (socket->bytesToWrite() > 0) {
+            if (!socket->waitForBytesWritten(DRAIN_TIMEOUT_MS))
+                break;
+        }
+    };
+    writeOut();     // Room below MAX_UNSENT_BYTES for the tail
+    BufferedSink::drain();
+    writeOut();
+}
+
+// ================================================================
+//  StdoutSink
+// ================================================================
+
+StdoutSink::StdoutSink(const QString &name, QObject *parent)
+    : BufferedSink(name, parent)
+{
+    out.open(stdout, QIODevice::WriteOnly | QIODevice::Unbuffered);
+}
+
+int StdoutSink::writeBatch(const QVector<SensorReading> &batch)
+{
+    if (out.write(toNdjson(serializer, batch)) < 0)
+        return 0;
+    return batch.size();
+}
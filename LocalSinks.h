@@ -0,0 +1,73 @@
+/////////////////////////////////////////////////////////////
+// LOCALSINKS.H - File, Socket and Stdout Telemetry Sinks
+/////////////////////////////////////////////////////////////
+
+#ifndef LOCALSINKS_H
+#define LOCALSINKS_H
+
+#include <QFile>
+#include <QLocalSocket>
+
+#include "TelemetrySink.h"
+
+// All local sinks write NDJSON: one compact JSON reading per line,
+// in the same shape the HTTP API accepts.
+
+// Appends readings to a local file
+class FileSink : public BufferedSink
+{
+    Q_OBJECT
+
+public:
+    FileSink(const QString &name, const QString &path, QObject *parent = nullptr);
+    QString type() const override { return "file"; }
+
+protected:
+    int writeBatch(const QVector<SensorReading> &batch) override;
+
+private:
+    QFile file;
+};
+
+// Streams readings to a Unix-domain socket server, reconnecting
+// whenever the connection drops
+class UnixSocketSink : public BufferedSink
+{
+    Q_OBJECT
+
+public:
+    UnixSocketSink(const QString &name, const QString &path, QObject *parent = nullptr);
+    QString type() const override { return "unix"; }
+    void drain() override;
+
+protected:
+    int writeBatch(const QVector<SensorReading> &batch) override;
+
+private:
+    QString       path;
+    QLocalSocket *socket;
+
+    // Don't let a stalled reader grow the socket's write buffer
+    static const qint64 MAX_UNSENT_BYTES = 1024 * 1024;
+
+    // How long drain() waits to connect and to hand the tail over
+    static const int DRAIN_TIMEOUT_MS = 2000;
+};
+
+// Writes readings to standard output
+class StdoutSink : public BufferedSink
+{
+    Q_OBJECT
+
+public:
+    explicit StdoutSink(const QString &name, QObject *parent = nullptr);
+    QString type() const override { return "stdout"; }
+
+protected:
+    int writeBatch(const QVector<SensorReading> &batch) override;
+
+private:
+    QFile out;
+};
+
+#endif // LOCALSINKS_H
@@ -0,0 +1,124 @@
+/////////////////////////////////////////////////////////////
+// MINMAXPYRAMID.CPP - Multi-Resolution Min/Max Index
+/////////////////////////////////////////////////////////////
+
+#include "MinMaxPyramid.h"
+#include <algorithm>
+
+void MinMaxPyramid::build(const QPointF *points, int count)
+{
+    levels.clear();
+    if (count < 2)
+        return;
+
+    // Level 0 pairs up the points; a lone last point is its own pair
+    QVector<Node> pairs((count + 1) / 2);
+    for (int p = 0; p < pairs.size(); p++) {
+        const int a = 2 * p;
+        const int b = std::min(a + 1, count - 1);
+        pairs[p].minIndex = points[b].y() < points[a].y() ? b : a;
+        pairs[p].maxIndex = points[b].y() > points[a].y() ? b : a;
+    }
+    levels.append(pairs);
+
+    while (levels.last().size() > 1) {
+        const QVector<Node> &below = levels.last();
+        QVector<Node> above((below.size() + 1) / 2);
+        for (int p = 0; p < above.size(); p++) {
+            const Node &a = below[2 * p];
+            const Node &b = below[std::min(2 * p + 1, below.size() - 1)];
+            above[p].minIndex = points[b.minIndex].y() < points[a.minIndex].y() ? b.minIndex
+                                                                                : a.minIndex;
+            above[p].maxIndex = points[b.maxIndex].y() > points[a.maxIndex].y() ? b.maxIndex
+                                                                                : a.maxIndex;
+        }
+        levels.append(above);
+    }
+}
+
+// Bottom-up segment tree walk: an odd left edge or an odd right
+// edge is a node that lies wholly inside the range, the rest moves
+// up a level
+void MinMaxPyramid::range(const QPointF *points, int from, int to,
+                          int &minIndex, int &maxIndex) const
+{
+    minIndex = maxIndex = from;
+    auto take = [&](int low, int high) {
+        if (points[low].y() < points[minIndex].y())
+            minIndex = low;
+        if (points[high].y() > points[maxIndex].y())
+            maxIndex = high;
+    };
+
+    int i = from, j = to;
+    if (i & 1) {
+        take(i, i);
+        i++;
+    }
+    if (j & 1) {
+        j--;
+        take(j, j);
+    }
+    i >>= 1;
+    j >>= 1;
+
+    for (int k = 0; i < j && k < levels.size(); k++) {
+        const Node *level = levels[k].constData();
+        if (i & 1) {
+            take(level[i].minIndex, level[i].maxIndex);
+            i++;
+        }
+        if (j & 1) {
+            j--;
+            take(level[j].minIndex, level[j].maxIndex);
+        }
+        i >>= 1;
+        j >>= 1;
+    }
+}
+
+void MinMaxPyramid::envelope(const QPointF *points, int count, double fromX, double toX,
+                             int buckets, QVector<QPointF> &out) const
+{
+    out.resize(0);
+    if (count == 0 || toX <= fromX || buckets < 1)
+        return;
+
+    auto lowerBound = [points, count](int start, double x) {
+        return int(std::lower_bound(points + start, points + count, x,
+                                    [](const QPointF &p, double v) { return p.x() < v; })
+                   - points);
+    };
+    const int first = lowerBound(0, fromX);
+    const int last  = int(std::upper_bound(points + first, points + count, toX,
+                                           [](double v, const QPointF &p) { return v < p.x(); })
+                          - points);
+
+    out.reserve(2 * buckets + 2);
+    if (first > 0)
+        out.append(points[first - 1]);
+
+    if (last - first <= 2 * buckets) {
+        for (int i = first; i < last; i++)
+            out.append(points[i]);
+    } else {
+        const double width = (toX - fromX) / buckets;
+        int start = first;
+        for (int b = 1; b <= buckets && start < last; b++) {
+            const int end = b == buckets ? last
+                                         : std::min(lowerBound(start, fromX + b * width), last);
+            if (end == start)
+                continue;
+
+            int low, high;
+            range(points, start, end, low, high);
+            out.append(points[std::min(low, high)]);
+            if (low != high)
+                out.append(points[std::max(low, high)]);
+            start = end;
+        }
+    }
+
+    if (last < count)
+        out.append(points[last]);
+}
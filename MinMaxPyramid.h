@@ -0,0 +1,50 @@
+/////////////////////////////////////////////////////////////
+// MINMAXPYRAMID.H - Multi-Resolution Min/Max Index Header
+/////////////////////////////////////////////////////////////
+
+#ifndef MINMAXPYRAMID_H
+#define MINMAXPYRAMID_H
+
+#include <QPointF>
+#include <QVector>
+
+// Min/max envelope over a line sorted by x, at every power-of-two
+// resolution: level k holds, for each run of 2^(k+1) points, the
+// index of its lowest and its highest point. Any index range is
+// then answered from O(log n) nodes, so a visible window of any
+// width reduces to one min/max pair per pixel in O(pixels · log n)
+// without touching the points in between.
+//
+// Unlike LTTB or every-Nth sampling an envelope always contains the
+// extremes: a one-sample spike shows at every zoom level.
+//
+// The pyramid keeps indices, not values; every call takes the same
+// points it was built from. About one node (8 bytes) per point.
+class MinMaxPyramid
+{
+public:
+    void build(const QPointF *points, int count);
+    void clear() { levels.clear(); }
+
+    // Indices of the lowest and highest point in points[from, to);
+    // from < to
+    void range(const QPointF *points, int from, int to, int &minIndex, int &maxIndex) const;
+
+    // The points with fromX <= x <= toX as at most two points
+    // (low, high, in x order) per bucket, 'buckets' equal buckets
+    // across the window; the nearest point outside each edge is
+    // added so the line runs off the sides. Copied as is when the
+    // window holds no more than 2 * buckets points.
+    void envelope(const QPointF *points, int count, double fromX, double toX,
+                  int buckets, QVector<QPointF> &out) const;
+
+private:
+    struct Node {
+        qint32 minIndex;
+        qint32 maxIndex;
+    };
+
+    QVector<QVector<Node>> levels;
+};
+
+#endif // MINMAXPYRAMID_H
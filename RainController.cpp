@@ -0,0 +1,638 @@
+/////////////////////////////////////////////////////////////
+// RAINCONTROLLER.CPP - Barrel Release Controller
+/////////////////////////////////////////////////////////////
+
+#include "RainController.h"
+#include <QDateTime>
+#include <QDebug>
+#include <QFile>
+#include <QStandardPaths>
+#ifdef RasPi
+#include <wiringPi.h>
+#endif
+
+// ================================================================
+//  Constructor / Destructor
+// ================================================================
+
+RainController::RainController(QObject *parent)
+    : QObject(parent)
+{
+    // On-device history store
+    const QString dataDir = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
+    store = new TimeSeriesStore(dataDir + "/history", this);
+    store->open();
+    snapshotPath = dataDir + "/controller.snapshot";
+
+    // Timers
+    monitoringTimer = new QTimer(this);
+    releaseTimer    = new QTimer(this);
+    connect(monitoringTimer, &QTimer::timeout,
+            this, &RainController::onMonitoringTick);
+    connect(releaseTimer, &QTimer::timeout,
+            this, &RainController::onReleaseTick);
+
+    // Sensor reads busy-wait on GPIO and SPI; they run here, off
+    // the thread serving the timers, the network and any UI
+    sensorThread = new QThread(this);
+    sensorThread->setObjectName("sensors");
+    sensorContext = new QObject();
+    sensorContext->moveToThread(sensorThread);
+    connect(sensorThread, &QThread::finished, sensorContext, &QObject::deleteLater);
+    sensorThread->start();
+}
+
+RainController::~RainController()
+{
+    sensorThread->quit();
+    sensorThread->wait();
+    saveSnapshot();
+}
+
+void RainController::start()
+{
+    if (metricsPort > 0) {
+        metricsServer = new LocalHttpServer(this);
+        metricsServer->route("/metrics", [this](const QUrlQuery &) {
+            LocalHttpServer::Response r;
+            r.contentType = "text/plain; version=0.0.4; charset=utf-8";
+            r.body = MetricsFormat::toPrometheus(dbWriter.metrics())
+                     + MetricsFormat::toPrometheus(tickStats);
+            return r;
+        });
+        metricsServer->route("/metrics.json", [this](const QUrlQuery &) {
+            LocalHttpServer::Response r;
+            r.contentType = "application/json";
+            r.body = MetricsFormat::toJson(dbWriter.metrics(), &tickStats);
+            return r;
+        });
+        metricsServer->route("/query", [this](const QUrlQuery &params) {
+            return handleQuery(params);
+        });
+        metricsServer->listen(metricsAddress, quint16(metricsPort));
+    }
+
+    // Hardware
+    distanceSensor.initialize();
+    moistureSensor.initialize();
+#ifdef RasPi
+    pinMode(VALVE_OPEN_PIN, OUTPUT);
+    pinMode(VALVE_CLOSE_PIN, OUTPUT);
+#endif
+
+    // Pick up where we left off; only a first run (or an
+    // unreadable snapshot) starts cold
+    if (!restoreSnapshot()) {
+        shutValve();
+        enterMonitoringMode();
+        QTimer::singleShot(0, this, &RainController::onMonitoringTick);
+    }
+}
+
+// ================================================================
+//  State Transitions
+// ================================================================
+
+void RainController::enterMonitoringMode()
+{
+    systemState = SystemState::Monitoring;
+    saveSnapshot();
+
+    releaseTimer->stop();
+    monitoringTimer->start(monitoringInterval * 1000);
+
+    emit stateChanged(systemState);
+    emit changed();
+
+    //qDebug() << "-> MONITORING mode (interval:"
+    //         << monitoringInterval << "s)";
+}
+
+void RainController::enterReleaseMode()
+{
+    // Only auto-release if auto control is on
+    if (!isAuto) {
+        //qDebug() << "Auto control OFF — skipping release";
+        return;
+    }
+
+    systemState = SystemState::Releasing;
+    emit stateChanged(systemState);
+
+    openValve();
+    saveSnapshot();
+    recordValveState();
+    dbWriter.sendValveState(true);
+
+    monitoringTimer->stop();
+    releaseTimer->start(releaseInterval * 1000);
+
+    emit changed();
+}
+
+// ================================================================
+//  MONITORING tick
+// ================================================================
+
+void RainController::onMonitoringTick()
+{
+    //qDebug() << "-- Monitoring tick --";
+
+    // Back to the usual cadence after a resumed first tick
+    if (monitoringTimer->interval() != monitoringInterval * 1000)
+        monitoringTimer->setInterval(monitoringInterval * 1000);
+
+    if (isAuto)
+    {
+        startTick();    // Enters release mode from decide() if conditions are met
+        return;
+    }
+
+    recordValveState();
+    saveSnapshot();
+}
+
+// ================================================================
+//  RELEASE tick
+// ================================================================
+
+void RainController::onReleaseTick()
+{
+    //qDebug() << "-- Release tick --";
+
+    if (releaseTimer->interval() != releaseInterval * 1000)
+        releaseTimer->setInterval(releaseInterval * 1000);
+
+    startTick();        // Back to monitoring from decide() if conditions are met
+}
+
+// ================================================================
+//  Tick Pipeline
+// ================================================================
+
+void RainController::startTick()
+{
+    if (tick.running) {
+        tickStats.overruns++;
+        qWarning() << "Tick skipped: the previous one is still running";
+        return;
+    }
+
+    tick = Tick();
+    tick.running    = true;
+    tick.startState = systemState;
+    tick.clock.start();
+    lastTickMs = QDateTime::currentMSecsSinceEpoch();
+
+    // Forecast: one request for all three series
+    fetcher.fetchPredictions(gridX, gridY,
+                             { datatype::PrecipitationAmount,
+                               datatype::ProbabilityofPrecipitation,
+                               datatype::Temperature },
+                             [this](const NOAAWeatherFetcher::Predictions &predictions) {
+                                 onForecast(predictions);
+                             });
+
+    // Sensors, meanwhile, on their thread; the result comes back
+    // here with the controller as context
+    QMetaObject::invokeMethod(sensorContext, [this]() {
+        const double raw     = distanceSensor.getDistance();
+        const double percent = moistureSensor.getMoisture();
+        QMetaObject::invokeMethod(this, [this, raw, percent]() { onSensed(raw, percent); },
+                                  Qt::QueuedConnection);
+    }, Qt::QueuedConnection);
+}
+
+void RainController::onSensed(double rawDistance, double moisturePercent)
+{
+    tickStats.record(TickMetrics::Sense, tick.clock.elapsed());
+    tick.sensed = true;
+
+    depth = depthFromReading(rawDistance);
+    recordPoint("depth_sensor", depth);
+    dbWriter.sendDepthReading(depth);
+
+    moisture = moisturePercent;
+    recordPoint("moisture_sensor", moisture);
+    dbWriter.sendMoistureReading(moisture);
+
+    // Decide on the recent mean rather than one noisy reading
+    if (moistureSmoothingMinutes > 0) {
+        const qint64 now = QDateTime::currentMSecsSinceEpoch();
+        const QueryResult recent = store->query("moisture_sensor",
+                                                now - moistureSmoothingMinutes * 60 * 1000LL,
+                                                now, 60 * 1000, QueryAggregate::Mean);
+        double  sum   = 0;
+        quint32 count = 0;
+        for (const QueryBucket &b : recent.buckets) {
+            sum   += b.value * b.count;
+            count += b.count;
+        }
+        if (count > 0)
+            moisture = sum / count;
+    }
+
+    // Safety: if sensor fails repeatedly during release, shut valve
+    if (sensorFailCount >= MAX_SENSOR_FAILS && systemState == SystemState::Releasing) {
+        qWarning() << "Sensor failed during release — shutting valve for safety";
+        shutValve();
+        recordValveState();
+        dbWriter.sendValveState(false);
+        enterMonitoringMode();
+    }
+
+    tryDecide();
+    finishTick();
+}
+
+void RainController::onForecast(const NOAAWeatherFetcher::Predictions &predictions)
+{
+    tickStats.record(TickMetrics::Forecast, tick.clock.elapsed());
+    tick.forecast = true;
+
+    lastRainAmount  = predictions.value(datatype::PrecipitationAmount);
+    lastRainProb    = predictions.value(datatype::ProbabilityofPrecipitation);
+    lastTemperature = predictions.value(datatype::Temperature);
+    emit forecastUpdated();
+
+    dbWriter.sendWeatherData("precip_amount", "mm",  lastRainAmount);
+    dbWriter.sendWeatherData("precip_prob",   "%",   lastRainProb);
+    dbWriter.sendWeatherData("temperature",   "C",   lastTemperature);
+
+    // Cumulative rain, recorded so its chart keeps updating
+    cumRain = calculateCumulativeValue(lastRainAmount, 2);
+    recordPoint("cumulative_rain", cumRain);
+
+    tryDecide();
+    finishTick();
+}
+
+// The readings alone settle most ticks: overflow always releases,
+// an empty barrel or moist soil never does. Only in between does
+// the forecast have to be waited for.
+void RainController::tryDecide()
+{
+    if (tick.decided || !tick.sensed)
+        return;
+
+    if (depth > overflowThreshold)
+        decide(true);
+    else if (depth < emptyThreshold || moisture > moistureThreshold)
+        decide(false);
+    else if (tick.forecast)
+        decide(cumRain <= forecastThreshold);
+}
+
+void RainController::decide(bool release)
+{
+    tick.decided = true;
+    tickStats.record(TickMetrics::Decide, tick.clock.elapsed());
+    if (!tick.forecast)
+        tickStats.earlyDecisions++;
+
+    updateReleaseReason();
+    emit changed();
+
+    // Manual control or the sensor safety took over meanwhile
+    if (systemState != tick.startState)
+        return;
+
+    if (tick.startState == SystemState::Monitoring) {
+        if (release && isAuto) {
+            enterReleaseMode();
+            return;
+        }
+        recordValveState();
+        saveSnapshot();
+    } else if (!release) {
+        shutValve();
+        recordValveState();
+        dbWriter.sendValveState(false);
+
+        enterMonitoringMode();
+    } else {
+        recordValveState();
+        dbWriter.sendValveState(true);
+        saveSnapshot();
+    }
+}
+
+void RainController::finishTick()
+{
+    if (!tick.running || !tick.sensed || !tick.forecast)
+        return;
+
+    tick.running = false;
+    tickStats.record(TickMetrics::Total, tick.clock.elapsed());
+    tickStats.ticks++;
+
+    // An early decision showed the reason before the forecast
+    updateReleaseReason();
+    emit changed();
+    saveSnapshot();
+}
+
+void RainController::updateReleaseReason()
+{
+    reason = ReleaseReason::None;
+
+    if (moisture < moistureThreshold && cumRain < forecastThreshold)
+        reason = ReleaseReason::DryAndForecast;
+    else if (moisture < moistureThreshold)
+        reason = ReleaseReason::Dry;
+    else if (cumRain < forecastThreshold)
+        reason = ReleaseReason::Forecast;
+    if (depth > overflowThreshold)
+        reason = ReleaseReason::Overflow;
+}
+
+// ================================================================
+//  Auto Control / Manual Override
+// ================================================================
+
+void RainController::setAutoControl(bool enabled)
+{
+    isAuto = enabled;
+
+    if (enabled) {
+        //qDebug() << "Auto control ENABLED";
+
+        // If valve was manually opened, shut it and reset
+        if (isOpen && systemState != SystemState::Releasing) {
+            shutValve();
+            recordValveState();
+            dbWriter.sendValveState(false);
+        }
+
+        // Make sure we're in monitoring mode
+        if (systemState != SystemState::Monitoring)
+            enterMonitoringMode();
+    } else {
+        //qDebug() << "Auto control DISABLED (manual mode)";
+
+        // If currently releasing, stop
+        if (systemState == SystemState::Releasing) {
+            shutValve();
+            recordValveState();
+            dbWriter.sendValveState(false);
+            enterMonitoringMode();
+        }
+    }
+
+    emit changed();
+    saveSnapshot();
+}
+
+void RainController::toggleValve()
+{
+    // Manual control takes over from auto control
+    if (isAuto)
+        setAutoControl(false);
+
+    if (isOpen) {
+        shutValve();
+
+        if (systemState == SystemState::Releasing)
+            enterMonitoringMode();
+    } else {
+        openValve();
+    }
+
+    recordValveState();
+    dbWriter.sendValveState(isOpen);
+    emit changed();
+    saveSnapshot();
+}
+
+// ================================================================
+//  Warm Restart
+// ================================================================
+
+void RainController::saveSnapshot()
+{
+    ControllerSnapshot snap;
+    snap.savedMs       = QDateTime::currentMSecsSinceEpoch();
+    snap.lastTickMs    = lastTickMs;
+    snap.state         = static_cast<qint32>(systemState);
+    snap.releaseReason = static_cast<qint32>(reason);
+    snap.valveOpen     = isOpen;
+    snap.autoControl   = isAuto;
+    snap.lastDepth     = depth;
+    snap.lastMoisture  = moisture;
+    snap.lastCumRain   = cumRain;
+    snap.rainAmount    = lastRainAmount;
+    snap.rainProb      = lastRainProb;
+    snap.temperature   = lastTemperature;
+    snap.save(snapshotPath);
+}
+
+// Restore the last snapshot and resume its mode. The valve is pulsed
+// to the position the snapshot records, as a cold start shuts it: a
+// pulse cut off by a power loss, or a snapshot that failed to save,
+// may have left it elsewhere. The first tick comes when it would
+// have been due.
+bool RainController::restoreSnapshot()
+{
+    ControllerSnapshot snap;
+    if (!snap.load(snapshotPath))
+        return false;
+
+    const qint64 now = QDateTime::currentMSecsSinceEpoch();
+    qDebug() << "Resuming from snapshot saved" << (now - snap.savedMs) / 1000 << "s ago";
+
+    reason          = snap.releaseReason >= 0
+                      && snap.releaseReason <= static_cast<qint32>(ReleaseReason::DryAndForecast)
+                          ? static_cast<ReleaseReason>(snap.releaseReason)
+                          : ReleaseReason::None;
+    isOpen          = snap.valveOpen;
+    isAuto          = snap.autoControl;
+    depth           = snap.lastDepth;
+    moisture        = snap.lastMoisture;
+    cumRain         = snap.lastCumRain;
+    lastTickMs      = snap.lastTickMs;
+    lastRainAmount  = snap.rainAmount;
+    lastRainProb    = snap.rainProb;
+    lastTemperature = snap.temperature;
+
+    emit forecastUpdated();
+
+    const bool releasing = snap.state == static_cast<qint32>(SystemState::Releasing)
+                           && isAuto && isOpen;
+    QTimer *timer;
+    int intervalMs;
+    if (releasing) {
+        systemState = SystemState::Releasing;
+        emit stateChanged(systemState);
+        monitoringTimer->stop();
+        timer      = releaseTimer;
+        intervalMs = releaseInterval * 1000;
+    } else {
+        enterMonitoringMode();
+        timer      = monitoringTimer;
+        intervalMs = monitoringInterval * 1000;
+    }
+
+    if (isOpen)
+        openValve();
+    else
+        shutValve();
+
+    const qint64 untilDue = lastTickMs + intervalMs - now;
+    timer->start(int(qBound<qint64>(0, untilDue, intervalMs)));
+
+    emit changed();
+    return true;
+}
+
+// ================================================================
+//  Depth Measurement
+// ================================================================
+
+double RainController::depthFromReading(double raw)
+{
+    // Sensor returned error (-1)
+    if (raw < 0) {
+        sensorFailCount++;
+        qWarning() << "Sensor read failed (" << sensorFailCount
+                   << "/" << MAX_SENSOR_FAILS << ")";
+
+        if (sensorFailCount >= MAX_SENSOR_FAILS)
+            emit changed();    // Shows the sensor offline
+
+        return depth;  // Return last known good value
+    }
+
+    // Sensor OK — reset fail counter; the tick's change
+    // notification clears the error
+    sensorFailCount = 0;
+
+    double cm = barrelDepth - raw;
+
+    if (cm > barrelDepth) cm = barrelDepth;
+    if (cm < 0)           cm = 0;
+
+    //qDebug() << "Depth:" << cm << "cm (raw sensor:" << raw << "cm)";
+    return cm;
+}
+
+// ================================================================
+//  Valve Control
+// ================================================================
+
+// Both record the new position before pulsing, so a snapshot never
+// claims the valve shut while it may be open; restoreSnapshot()
+// drives it there again in case the pulse was cut short
+void RainController::openValve()
+{
+    isOpen = true;
+    saveSnapshot();
+
+#ifdef RasPi
+   //digitalWrite(VALVE_PIN, HIGH);
+   digitalWrite(VALVE_CLOSE_PIN, LOW);
+   delay(50);
+
+   digitalWrite(VALVE_OPEN_PIN, HIGH);
+   delay(VALVE_PULSE_MS);
+   digitalWrite(VALVE_OPEN_PIN, LOW);
+#endif
+    //qDebug() << "VALVE OPENED";
+}
+
+void RainController::shutValve()
+{
+    isOpen = false;
+    saveSnapshot();
+
+#ifdef RasPi
+    //digitalWrite(VALVE_PIN, LOW);
+    digitalWrite(VALVE_OPEN_PIN, LOW);
+    delay(50);
+    digitalWrite(VALVE_CLOSE_PIN, LOW);
+    digitalWrite(VALVE_CLOSE_PIN, HIGH);
+    delay(VALVE_PULSE_MS);
+    //digitalWrite(VALVE_CLOSE_PIN, LOW);
+#endif
+    //qDebug() << "VALVE SHUT";
+}
+
+// ================================================================
+//  Data Recording
+// ================================================================
+
+// Append a timestamped sample to the store and announce it
+void RainController::recordPoint(const QString &seriesId, double value)
+{
+    const QDateTime now = QDateTime::currentDateTime();
+    store->append(seriesId, now.toMSecsSinceEpoch(), value);
+    emit pointRecorded(seriesId, {now, value});
+}
+
+void RainController::recordValveState()
+{
+    recordPoint("valve_state", static_cast<double>(isOpen));
+}
+
+// GET /query?series=depth_sensor&from=-30d&to=0&bucket=1m&agg=mean
+// from/to are epoch ms, or offsets from now when not positive;
+// bucket is a duration ("60000", "1m", "1h", "1d")
+LocalHttpServer::Response RainController::handleQuery(const QUrlQuery &params) const
+{
+    LocalHttpServer::Response r;
+    const qint64 now = QDateTime::currentMSecsSinceEpoch();
+
+    auto param = [&params](const QString &key, const QString &fallback) {
+        return params.hasQueryItem(key) ? params.queryItemValue(key) : fallback;
+    };
+    auto timeParam = [&](const QString &key, const QString &fallback, qint64 &ms) {
+        if (!SeriesQuery::parseDuration(param(key, fallback), ms))
+            return false;
+        if (ms <= 0)
+            ms += now;
+        return true;
+    };
+
+    const QString series = param("series", QString());
+    qint64 fromMs, toMs, bucketMs;
+    QueryAggregate aggregate;
+    if (series.isEmpty()
+        || !timeParam("from", "-1d", fromMs)
+        || !timeParam("to", "0", toMs)
+        || !SeriesQuery::parseDuration(param("bucket", "1m"), bucketMs) || bucketMs <= 0
+        || !SeriesQuery::parseAggregate(param("agg", "mean"), aggregate)) {
+        r.status = 400;
+        r.body = "usage: /query?series=<name>&from=<ms|-30d>&to=<ms|0>&bucket=<1m>"
+                 "&agg=<min|max|mean|sum|count|last>\n";
+        return r;
+    }
+
+    const QueryResult result = store->query(series, fromMs, toMs, bucketMs, aggregate);
+    if (result.source.isEmpty()) {
+        r.status = 404;
+        r.body = "no history for " + series.toUtf8() + "\n";
+        return r;
+    }
+
+    r.contentType = "application/json";
+    r.body = SeriesQuery::toJson(result);
+    return r;
+}
+
+// ================================================================
+//  Process Stats
+// ================================================================
+
+qint64 residentSetKiB()
+{
+    QFile status("/proc/self/status");
+    if (!status.open(QIODevice::ReadOnly))
+        return 0;
+
+    // "VmRSS:     12345 kB"; /proc reports no size, so read by line
+    QByteArray line;
+    while (!(line = status.readLine()).isEmpty()) {
+        if (line.startsWith("VmRSS:"))
+            return line.mid(6).trimmed().split(' ').first().toLongLong();
+    }
+    return 0;
+}
@@ -0,0 +1,237 @@
+/////////////////////////////////////////////////////////////
+// RAINCONTROLLER.H - Barrel Release Controller Header
+/////////////////////////////////////////////////////////////
+
+#ifndef RAINCONTROLLER_H
+#define RAINCONTROLLER_H
+
+#include <QElapsedTimer>
+#include <QObject>
+#include <QThread>
+#include <QTimer>
+#include "noaaweatherfetcher.h"
+#include "DistanceSensor.h"
+#include "MoistureSensor.h"
+#include "DatabaseWriter.h"
+#include "LocalHttpServer.h"
+#include "TimeSeriesStore.h"
+#include "ControllerSnapshot.h"
+
+// ── System operating states ────────────────────────────────
+enum class SystemState {
+    Monitoring,
+    Releasing
+};
+
+enum class ReleaseReason {
+    None,
+    Overflow,
+    Forecast,
+    Dry,
+    DryAndForecast
+};
+
+// The whole control loop: sensors, forecast, release rules, valve,
+// history store, uplink and the local HTTP endpoint. Needs only
+// QtCore and QtNetwork, so it runs the same under the dashboard
+// and in the headless daemon; a front end watches the signals and
+// calls the two manual-control slots.
+//
+//  Two-state architecture:
+//    MONITORING  — slow timer, fetches weather, measures depth,
+//                  evaluates release rules
+//    RELEASING   — fast timer, measures depth, checks if target
+//                  has been reached, shuts valve when done
+//
+//  Each tick is asynchronous: the sensors are read on their own
+//  thread while the forecast request is in flight, and the
+//  decision is taken as soon as its inputs settle it — at once
+//  when the readings alone do (overflow, empty barrel, wet soil),
+//  otherwise when the forecast lands.
+class RainController : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit RainController(QObject *parent = nullptr);
+    ~RainController();
+
+    // Open the store, bring up the endpoint and the hardware, then
+    // resume from the snapshot or start cold. Connect first: the
+    // resumed state is announced from here.
+    void start();
+
+    // ── Tunable parameters ─────────────────────────────────
+
+    // Physical distance from the ultrasonic sensor (mounted at top)
+    // to the bottom of the barrel. All depth readings are calculated
+    // as: depth = barrelDepth − sensorReading
+    double barrelDepth = 137.16;                        // cm
+
+    // Forecast-based release triggers when BOTH conditions are met:
+    //   1. Current water depth  >  forecastReleaseDepthThreshold
+    //   2. 2-day cumulative rain >  forecastReleaseThreshold
+    // The system then drains down to forecastTargetDepth.
+    double forecastThreshold      = 15;       // mm  — min predicted rain (2-day sum)
+    double moistureThreshold      = 20;      // %  — minimum soil moisture to consider draining
+
+    // Overflow protection triggers when:
+    //   Current water depth  >  overflowThreshold
+    // This fires regardless of the rain forecast (safety mechanism).
+    // The system drains down to overflowTargetDepth.
+    double overflowThreshold     = 124;               // cm  — emergency release trigger
+    double emptyThreshold     = 13;                 // cm  — point at which the barrel is empty.
+    int monitoringInterval  = 3600;                    // Interval during closed valve mode (seconds)
+    int releaseInterval     = 300;                     // Interval during open valve mode (seconds)
+    bool sensorEnabled      = true;
+
+    // Decide on the mean moisture over this many minutes of stored
+    // history rather than the latest reading (0 = latest reading).
+    // Three hours spans a few monitoring ticks.
+    int moistureSmoothingMinutes = 180;
+
+    // Local HTTP endpoint: upload pipeline metrics as Prometheus
+    // text on /metrics and JSON on /metrics.json, history on
+    // /query (0 = endpoint off). A front end may add routes. No
+    // authentication, so only this machine may connect unless the
+    // address is widened (QHostAddress::Any for remote scraping).
+    int metricsPort         = 9180;
+    QHostAddress metricsAddress = QHostAddress(QHostAddress::LocalHost);
+
+    // ── State ──────────────────────────────────────────────
+    SystemState   state() const         { return systemState; }
+    ReleaseReason releaseReason() const { return reason; }
+    bool   valveOpen() const            { return isOpen; }
+    bool   autoControl() const          { return isAuto; }
+    bool   sensorOk() const             { return sensorFailCount < MAX_SENSOR_FAILS; }
+    double lastDepth() const            { return depth; }
+    double lastMoisture() const         { return moisture; }
+    double lastCumRain() const          { return cumRain; }
+
+    // Last forecast
+    const QVector<WeatherData> &rainAmount() const  { return lastRainAmount; }
+    const QVector<WeatherData> &rainProb() const    { return lastRainProb; }
+    const QVector<WeatherData> &temperature() const { return lastTemperature; }
+
+    const TimeSeriesStore &history() const  { return *store; }
+    const DatabaseWriter  &uplink() const   { return dbWriter; }
+    const TickMetrics     &tickMetrics() const { return tickStats; }
+    LocalHttpServer       *httpServer()     { return metricsServer; }
+
+    // GET /query?series=depth_sensor&from=-30d&to=0&bucket=1m&agg=mean
+    LocalHttpServer::Response handleQuery(const QUrlQuery &params) const;
+
+public slots:
+    void setAutoControl(bool enabled);
+    void toggleValve();                 // Manual override; turns auto control off
+
+signals:
+    // Any shown value changed: a reading, the mode, the valve or
+    // the control mode
+    void changed();
+
+    // Entered Monitoring or Releasing
+    void stateChanged(SystemState state);
+
+    // A sample was appended to the store ("depth_sensor",
+    // "moisture_sensor", "valve_state", "cumulative_rain")
+    void pointRecorded(const QString &seriesId, const WeatherData &point);
+
+    void forecastUpdated();
+
+private slots:
+    void onMonitoringTick();
+    void onReleaseTick();
+
+private:
+    // ── State ──────────────────────────────────────────────
+    SystemState   systemState = SystemState::Monitoring;
+    ReleaseReason reason      = ReleaseReason::None;
+    bool          isOpen      = false;
+    bool          isAuto      = true;
+    double        depth       = 0;
+    double        moisture    = 0;
+    double        cumRain     = 0;
+    qint64        lastTickMs  = 0;
+
+    // ── Warm restart ───────────────────────────────────────
+    // Saved at every transition and before every valve pulse;
+    // restored instead of a cold start (shut pulse plus an
+    // immediate tick)
+    QString snapshotPath;
+    void saveSnapshot();
+    bool restoreSnapshot();
+
+    // ── Hardware ───────────────────────────────────────────
+    //const int VALVE_PIN = 18;
+    static constexpr int VALVE_OPEN_PIN = 18;
+    static constexpr int VALVE_CLOSE_PIN = 23;
+    static constexpr int VALVE_PULSE_MS = 5000;
+
+    DistanceSensor distanceSensor;
+    void openValve();
+    void shutValve();
+
+    MoistureSensor moistureSensor;
+
+    // ── Depth measurement ──────────────────────────────────
+    double depthFromReading(double raw);
+    int sensorFailCount = 0;           // Consecutive failed readings
+    static const int MAX_SENSOR_FAILS = 3;  // Show error after this many
+
+    // ── State transitions ──────────────────────────────────
+    void enterReleaseMode();
+    void enterMonitoringMode();
+
+    // ── Tick pipeline ──────────────────────────────────────
+    // startTick() fans out to the sensor thread and the forecast
+    // request; onSensed() and onForecast() fan back in, decide()
+    // runs once, finishTick() when both are in
+    struct Tick {
+        bool          running    = false;
+        SystemState   startState = SystemState::Monitoring;
+        bool          sensed     = false;
+        bool          forecast   = false;
+        bool          decided    = false;
+        QElapsedTimer clock;                 // From startTick()
+    };
+    Tick        tick;
+    TickMetrics tickStats;
+    QThread    *sensorThread;
+    QObject    *sensorContext;       // Lives on sensorThread
+
+    void startTick();
+    void onSensed(double rawDistance, double moisturePercent);
+    void onForecast(const NOAAWeatherFetcher::Predictions &predictions);
+    void tryDecide();
+    void decide(bool release);
+    void finishTick();
+    void updateReleaseReason();
+
+    // ── Timers ─────────────────────────────────────────────
+    QTimer *monitoringTimer;
+    QTimer *releaseTimer;
+
+    // ── Weather ────────────────────────────────────────────
+    NOAAWeatherFetcher fetcher;
+    int gridX = 97;
+    int gridY = 71;
+    QVector<WeatherData> lastRainAmount;
+    QVector<WeatherData> lastRainProb;
+    QVector<WeatherData> lastTemperature;
+
+    // ── Data recording ─────────────────────────────────────
+    TimeSeriesStore *store;
+    void recordPoint(const QString &seriesId, double value);
+    void recordValveState();
+
+    // ── Uplink ─────────────────────────────────────────────
+    DatabaseWriter dbWriter;
+    LocalHttpServer *metricsServer = nullptr;
+};
+
+// Resident set size of this process in KiB (0 where unknown), for
+// the startup log line
+qint64 residentSetKiB();
+
+#endif // RAINCONTROLLER_H
@@ -0,0 +1,53 @@
+/////////////////////////////////////////////////////////////
+// READINGSERIALIZER.H - Allocation-Free JSON Serializer Header
+/////////////////////////////////////////////////////////////
+
+#ifndef READINGSERIALIZER_H
+#define READINGSERIALIZER_H
+
+#include <QByteArray>
+#include <QHash>
+#include <QString>
+
+#include "SensorReading.h"
+
+// Writes readings as compact JSON straight into a reusable byte
+// buffer. Unlike building a QJsonObject per reading, nothing is
+// allocated per reading once the buffer is warm: values are
+// formatted with integer arithmetic at the API's 2-decimal
+// precision, timestamps are formatted by hand (local time, the
+// same text as QDateTime::toString(Qt::ISODate)), and sensor ids
+// and units are escaped once and cached.
+//
+//   {"sensor_id":"depth_sensor","value":42.50,"unit":"cm","timestamp":"2025-06-01T14:00:00"}
+class ReadingSerializer
+{
+public:
+    explicit ReadingSerializer(int reserveBytes = 64 * 1024);
+
+    void clear() { buf.resize(0); }   // Keeps the reserved capacity
+    void appendJson(const SensorReading &reading);
+    void appendNdjson(const SensorReading &reading);
+
+    const QByteArray &bytes() const { return buf; }
+
+private:
+    QByteArray buf;
+    QHash<QString, QByteArray> quoted;   // Escaped, quoted strings seen before
+
+    // The formatted date/time for the last second seen; readings
+    // in a replay are usually close together
+    qint64 cachedSecond = -1;
+    char   cachedStamp[19];
+
+    const QByteArray &quote(const QString &text);
+    void appendFixed2(double value);
+    void appendTimestamp(qint64 timestampMs);
+};
+
+// Checks ReadingSerializer against the QJsonObject path on edge
+// values, then times both on a synthetic replay and prints the
+// result. Returns 1 on a mismatch, otherwise 0.
+int benchmarkSerializer(int readings);
+
+#endif // READINGSERIALIZER_H
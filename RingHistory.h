@@ -0,0 +1,85 @@
+/////////////////////////////////////////////////////////////
+// RINGHISTORY.H - Fixed-Capacity Ring Buffer History
+/////////////////////////////////////////////////////////////
+
+#ifndef RINGHISTORY_H
+#define RINGHISTORY_H
+
+#include <QVector>
+#include <QtGlobal>
+
+// Rolling history of the last N samples. append() is O(1) and,
+// once full, overwrites the oldest sample.
+//
+// Every sample is written twice, at slot i and at slot i + capacity,
+// so the live window [oldest .. newest] is always one contiguous
+// run of memory: data()/begin()/end() hand it on without unwrapping
+// (a chart still copies the run once when it is plotted whole).
+template <typename T>
+class RingHistory
+{
+public:
+    explicit RingHistory(int capacity = 100) { setCapacity(capacity); }
+
+    // Change the capacity, keeping the newest samples that fit
+    void setCapacity(int capacity)
+    {
+        capacity = qMax(1, capacity);
+        const int keep = qMin(count, capacity);
+        const T *newest = data() + count - keep;
+
+        QVector<T> grown(2 * capacity);
+        for (int i = 0; i < keep; i++) {
+            grown[i]            = newest[i];
+            grown[i + capacity] = newest[i];
+        }
+
+        buf   = grown;
+        cap   = capacity;
+        count = keep;
+        head  = keep % capacity;
+    }
+
+    void append(const T &item)
+    {
+        buf[head]       = item;
+        buf[head + cap] = item;
+        head = head + 1 == cap ? 0 : head + 1;
+        if (count < cap)
+            count++;
+    }
+
+    void clear() { count = 0; head = 0; }
+
+    int  capacity() const { return cap; }
+    int  size() const     { return count; }
+    bool isEmpty() const  { return count == 0; }
+
+    // Oldest to newest, contiguous
+    const T *data() const  { return buf.constData() + start(); }
+    const T *begin() const { return data(); }
+    const T *end() const   { return data() + count; }
+
+    const T &at(int i) const { return data()[i]; }
+    const T &first() const   { return at(0); }
+    const T &last() const    { return at(count - 1); }
+
+    QVector<T> toVector() const
+    {
+        QVector<T> out;
+        out.reserve(count);
+        for (const T &item : *this)
+            out.append(item);
+        return out;
+    }
+
+private:
+    QVector<T> buf;     // 2 * cap slots, mirrored halves
+    int cap   = 0;
+    int head  = 0;      // Next slot to write, in [0, cap)
+    int count = 0;
+
+    int start() const { return head >= count ? head - count : head - count + cap; }
+};
+
+#endif // RINGHISTORY_H
@@ -0,0 +1,267 @@
+/////////////////////////////////////////////////////////////
+// ROLLUPRING.CPP - Fixed-Width Rollup Tier
+/////////////////////////////////////////////////////////////
+
+#include "RollupRing.h"
+#include <QDebug>
+#include <algorithm>
+#include <cstring>
+#ifdef Q_OS_UNIX
+#include <sys/mman.h>
+#endif
+
+// On-disk layout (host byte order): a 64-byte header, then one
+// 64-byte record per slot
+static const char    RING_MAGIC[4] = { 'S', 'R', 'R', 'U' };
+static const quint16 RING_VERSION  = 1;
+static const int     RECORD_BYTES  = 64;
+
+struct RingHeader {
+    char    magic[4];
+    quint16 version;
+    quint16 recordBytes;
+    quint32 slotCount;
+    quint32 reserved;
+    qint64  widthMs;
+    quint8  reserved2[40];
+};
+static_assert(sizeof(RingHeader) == RECORD_BYTES, "ring header must fill one record");
+
+struct RollupRing::Record {
+    qint64  startMs;
+    qint64  lastMs;
+    quint32 count;              // 0 = empty slot
+    quint32 checksum;           // Over the record, this field zeroed
+    double  minValue;
+    double  maxValue;
+    double  sum;
+    double  last;
+    quint8  reserved[8];
+};
+
+// FNV-1a style, a 64-bit word at a time: a long-range read checks
+// tens of thousands of slots
+static quint32 checksumRecord(const void *record)
+{
+    quint64 words[RECORD_BYTES / 8];
+    std::memcpy(words, record, RECORD_BYTES);
+    words[2] &= 0xFFFFFFFFull;                // drop the checksum field itself
+    quint64 h = 14695981039346656037ull;
+    for (quint64 w : words) {
+        h ^= w;
+        h *= 1099511628211ull;
+    }
+    return quint32(h ^ (h >> 32));
+}
+
+RollupRing::RollupRing(qint64 widthMs, int ringSlots)
+    : width(widthMs)
+    , slotCount(ringSlots)
+{
+    static_assert(sizeof(Record) == RECORD_BYTES, "rollup record must stay 64 bytes");
+}
+
+RollupRing::~RollupRing()
+{
+    if (map)
+        file.unmap(map);
+    file.close();
+}
+
+// ================================================================
+//  Open
+// ================================================================
+
+bool RollupRing::open(const QString &path)
+{
+    const qint64 ringBytes = qint64(slotCount + 1) * RECORD_BYTES;
+
+    file.setFileName(path);
+    if (!file.open(QIODevice::ReadWrite)) {
+        qWarning() << "RollupRing: cannot open" << path << file.errorString();
+        return false;
+    }
+
+    QVector<RollupBucket> keep;
+    if (file.size() >= RECORD_BYTES) {
+        if (!(map = file.map(0, file.size()))) {
+            qWarning() << "RollupRing: cannot map" << path << file.errorString();
+            return false;
+        }
+
+        const RingHeader *hdr = reinterpret_cast<const RingHeader *>(map);
+        const bool known = std::memcmp(hdr->magic, RING_MAGIC, 4) == 0
+                           && hdr->version == RING_VERSION
+                           && hdr->recordBytes == RECORD_BYTES;
+        if (known && hdr->slotCount == quint32(slotCount) && hdr->widthMs == width
+            && file.size() == ringBytes)
+            return true;
+
+        // Retention (or width) changed: keep what still lines up
+        if (known) {
+            qDebug() << "RollupRing: re-slotting" << path;
+            const qint64 have = qMin<qint64>(hdr->slotCount, file.size() / RECORD_BYTES - 1);
+            for (qint64 i = 0; i < have; i++) {
+                RollupBucket b;
+                if (decode(reinterpret_cast<const Record *>(map + (i + 1) * RECORD_BYTES), b)
+                    && b.startMs % width == 0)
+                    keep.append(b);
+            }
+        } else {
+            qWarning() << "RollupRing: unrecognised ring" << path << "- starting afresh";
+        }
+
+        file.unmap(map);
+        map = nullptr;
+    }
+
+    // A fresh ring: truncating first zeroes it and keeps it sparse
+    if (!file.resize(0) || !file.resize(ringBytes) || !(map = file.map(0, ringBytes))) {
+        qWarning() << "RollupRing: cannot create" << path << file.errorString();
+        return false;
+    }
+
+    RingHeader *hdr = reinterpret_cast<RingHeader *>(map);
+    std::memcpy(hdr->magic, RING_MAGIC, 4);
+    hdr->version     = RING_VERSION;
+    hdr->recordBytes = RECORD_BYTES;
+    hdr->slotCount   = quint32(slotCount);
+    hdr->widthMs     = width;
+
+    // Oldest first, so a newer bucket wins a shared slot
+    std::sort(keep.begin(), keep.end(), [](const RollupBucket &a, const RollupBucket &b) {
+        return a.startMs < b.startMs;
+    });
+    for (const RollupBucket &b : keep)
+        store(b);
+
+    sync();
+    return true;
+}
+
+qint64 RollupRing::resume(qint64 lastMs)
+{
+    qint64 start = lastMs - lastMs % width;
+    for (int i = 0; i < slotCount && start >= 0; i++, start -= width) {
+        if (load(start, current))
+            return current.lastMs;
+    }
+    current = RollupBucket();
+    return 0;
+}
+
+// ================================================================
+//  Fold / Sync
+// ================================================================
+
+void RollupRing::add(qint64 timestampMs, double value)
+{
+    const qint64 start = timestampMs - timestampMs % width;
+    if (current.count > 0 && start != current.startMs) {
+        store(current);
+        current = RollupBucket();
+    }
+
+    if (current.count == 0) {
+        current.startMs  = start;
+        current.minValue = value;
+        current.maxValue = value;
+    } else {
+        current.minValue = qMin(current.minValue, value);
+        current.maxValue = qMax(current.maxValue, value);
+    }
+    current.sum   += value;
+    current.last   = value;
+    current.lastMs = timestampMs;
+    current.count++;
+}
+
+void RollupRing::sync()
+{
+    if (!map)
+        return;
+    if (current.count > 0)
+        store(current);
+#ifdef Q_OS_UNIX
+    // Only the pages written since the last sync go to the card
+    ::msync(map, size_t(qint64(slotCount + 1) * RECORD_BYTES), MS_SYNC);
+#endif
+}
+
+// ================================================================
+//  Slots
+// ================================================================
+
+RollupRing::Record *RollupRing::slot(qint64 startMs) const
+{
+    const qint64 index = (startMs / width) % slotCount;
+    return reinterpret_cast<Record *>(map + (index + 1) * RECORD_BYTES);
+}
+
+bool RollupRing::decode(const Record *r, RollupBucket &out)
+{
+    if (r->count == 0 || r->checksum != checksumRecord(r))
+        return false;
+
+    out.startMs  = r->startMs;
+    out.lastMs   = r->lastMs;
+    out.count    = r->count;
+    out.minValue = r->minValue;
+    out.maxValue = r->maxValue;
+    out.sum      = r->sum;
+    out.last     = r->last;
+    return true;
+}
+
+// The bucket starting at startMs, if its slot still holds it
+bool RollupRing::load(qint64 startMs, RollupBucket &out) const
+{
+    RollupBucket b;
+    if (!map || !decode(slot(startMs), b) || b.startMs != startMs)
+        return false;
+    out = b;
+    return true;
+}
+
+void RollupRing::store(const RollupBucket &b)
+{
+    Record *r = slot(b.startMs);
+    std::memset(r, 0, RECORD_BYTES);
+    r->startMs  = b.startMs;
+    r->lastMs   = b.lastMs;
+    r->count    = b.count;
+    r->minValue = b.minValue;
+    r->maxValue = b.maxValue;
+    r->sum      = b.sum;
+    r->last     = b.last;
+    r->checksum = checksumRecord(r);
+}
+
+// ================================================================
+//  Read
+// ================================================================
+
+QVector<RollupBucket> RollupRing::read(qint64 fromMs, qint64 toMs) const
+{
+    QVector<RollupBucket> out;
+    if (current.count == 0 || toMs < fromMs)
+        return out;
+
+    // Nothing is newer than the open bucket, and nothing a full
+    // ring older than it survives
+    qint64 first = qMax(fromMs, current.startMs - width * (slotCount - 1));
+    first = qMax<qint64>(first, 0);
+    first -= first % width;
+    const qint64 lastStart = qMin(toMs, current.startMs);
+    if (lastStart >= first)
+        out.reserve(int((lastStart - first) / width) + 1);
+
+    for (qint64 start = first; start <= lastStart; start += width) {
+        RollupBucket b;
+        if (start == current.startMs)
+            out.append(current);
+        else if (load(start, b))
+            out.append(b);
+    }
+    return out;
+}
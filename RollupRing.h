@@ -0,0 +1,73 @@
+/////////////////////////////////////////////////////////////
+// ROLLUPRING.H - Fixed-Width Rollup Tier Header
+/////////////////////////////////////////////////////////////
+
+#ifndef ROLLUPRING_H
+#define ROLLUPRING_H
+
+#include <QFile>
+#include <QVector>
+
+// Summary of one series over one time bucket
+struct RollupBucket {
+    qint64  startMs  = 0;         // Bucket start, a multiple of its width
+    qint64  lastMs   = 0;         // Newest sample folded in
+    quint32 count    = 0;
+    double  minValue = 0;
+    double  maxValue = 0;
+    double  sum      = 0;
+    double  last     = 0;         // Value of the newest sample
+
+    double mean() const { return count ? sum / count : 0; }
+};
+
+// One rollup tier of one series: buckets of a fixed width, kept
+// in a memory-mapped file of fixed slots indexed by
+// (start / width) % slotCount. A bucket overwrites the one a full
+// ring earlier, so the file never grows and retention is simply
+// slotCount * width.
+//
+// The open (newest) bucket is folded in memory and written to its
+// slot when it closes or on sync(); every slot carries a checksum,
+// so a torn slot just reads as missing.
+class RollupRing
+{
+public:
+    RollupRing(qint64 widthMs, int ringSlots);
+    ~RollupRing();
+
+    // Map the file, creating it if needed. A file written with a
+    // different width or retention is re-slotted in place.
+    bool open(const QString &path);
+
+    // Pick up the newest bucket at or before lastMs as the open
+    // one. Returns the newest sample time it covers (0 if none):
+    // later samples must be folded in again with add().
+    qint64 resume(qint64 lastMs);
+
+    void add(qint64 timestampMs, double value);
+    void sync();                              // Write the open bucket, msync
+
+    // Buckets overlapping [fromMs, toMs], oldest first; buckets
+    // with no samples are skipped
+    QVector<RollupBucket> read(qint64 fromMs, qint64 toMs) const;
+
+    qint64 widthMs() const { return width; }
+    qint64 retentionMs() const { return width * slotCount; }
+
+private:
+    struct Record;
+
+    qint64 width;
+    int    slotCount;
+    QFile  file;
+    uchar *map = nullptr;
+    RollupBucket current;                     // Open bucket, not yet in its slot
+
+    Record *slot(qint64 startMs) const;
+    bool    load(qint64 startMs, RollupBucket &out) const;
+    void    store(const RollupBucket &b);
+    static bool decode(const Record *r, RollupBucket &out);
+};
+
+#endif // ROLLUPRING_H
@@ -0,0 +1,37 @@
+/////////////////////////////////////////////////////////////
+// SENSORREADING.H - Single telemetry reading
+/////////////////////////////////////////////////////////////
+
+#ifndef SENSORREADING_H
+#define SENSORREADING_H
+
+#include <QString>
+#include <QByteArray>
+#include <QtGlobal>
+
+// Upload lanes, most important first. When bandwidth is short
+// a lane only gets to send once every lane above it is empty.
+enum class UploadPriority : quint8 {
+    Safety   = 0,   // Valve events
+    Live     = 1,   // Current sensor readings
+    Forecast = 2,   // Weather forecast points
+    Backfill = 3    // Bulk history, sent only with budget to spare
+};
+static const int UPLOAD_PRIORITY_COUNT = 4;
+
+// One reading as it travels through the upload pipeline.
+// The idempotency key is assigned once when the reading is
+// queued and reused on every replay, so the server can
+// deduplicate uploads that were retried after an outage.
+struct SensorReading {
+    quint64    seq = 0;          // Position in the upload queue
+    QByteArray key;              // Idempotency key (stable across replays)
+    QString    sensorId;
+    QString    unit;
+    qint64     timestampMs = 0;  // Milliseconds since epoch
+    double     value = 0.0;
+    UploadPriority priority = UploadPriority::Live;
+    int        attempt = 0;          // Upload retries so far (not persisted)
+};
+
+#endif // SENSORREADING_H
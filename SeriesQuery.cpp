@@ -0,0 +1,197 @@
+/////////////////////////////////////////////////////////////
+// SERIESQUERY.CPP - Bucketed Range Queries
+/////////////////////////////////////////////////////////////
+
+#include "SeriesQuery.h"
+#include <QtNumeric>
+#include <limits>
+
+// ================================================================
+//  Accumulator
+// ================================================================
+
+// Four independent lanes carry no dependency from one element to
+// the next, so the compiler can keep them in vector registers; a
+// decoded block is a few thousand contiguous doubles
+void QueryAccumulator::addRun(const double *values, int n)
+{
+    if (n <= 0)
+        return;
+
+    const double inf = std::numeric_limits<double>::infinity();
+    double mn[4] = { inf, inf, inf, inf };
+    double mx[4] = { -inf, -inf, -inf, -inf };
+    double sm[4] = { 0, 0, 0, 0 };
+
+    int i = 0;
+    for (; i + 4 <= n; i += 4) {
+        for (int l = 0; l < 4; l++) {
+            const double v = values[i + l];
+            mn[l] = v < mn[l] ? v : mn[l];
+            mx[l] = v > mx[l] ? v : mx[l];
+            sm[l] += v;
+        }
+    }
+    for (; i < n; i++) {
+        const double v = values[i];
+        mn[0] = v < mn[0] ? v : mn[0];
+        mx[0] = v > mx[0] ? v : mx[0];
+        sm[0] += v;
+    }
+
+    addSummary(quint32(n),
+               qMin(qMin(mn[0], mn[1]), qMin(mn[2], mn[3])),
+               qMax(qMax(mx[0], mx[1]), qMax(mx[2], mx[3])),
+               (sm[0] + sm[1]) + (sm[2] + sm[3]),
+               values[n - 1]);
+}
+
+void QueryAccumulator::addSummary(quint32 n, double min, double max, double total)
+{
+    if (n == 0)
+        return;
+    minValue = count == 0 ? min : qMin(minValue, min);
+    maxValue = count == 0 ? max : qMax(maxValue, max);
+    sum     += total;
+    count   += n;
+}
+
+void QueryAccumulator::addSummary(quint32 n, double min, double max, double total,
+                                  double lastValue)
+{
+    addSummary(n, min, max, total);
+    if (n > 0)
+        last = lastValue;
+}
+
+double QueryAccumulator::result(QueryAggregate aggregate) const
+{
+    switch (aggregate) {
+    case QueryAggregate::Min:   return minValue;
+    case QueryAggregate::Max:   return maxValue;
+    case QueryAggregate::Mean:  return count ? sum / count : 0;
+    case QueryAggregate::Sum:   return sum;
+    case QueryAggregate::Count: return double(count);
+    case QueryAggregate::Last:  return last;
+    }
+    return 0;
+}
+
+// ================================================================
+//  Builder
+// ================================================================
+
+QueryBuilder::QueryBuilder(QueryResult &result)
+    : result(result)
+{
+}
+
+qint64 QueryBuilder::bucketStart(qint64 timestampMs) const
+{
+    qint64 rem = timestampMs % result.bucketMs;
+    if (rem < 0)
+        rem += result.bucketMs;
+    return timestampMs - rem;
+}
+
+qint64 QueryBuilder::bucketEnd(qint64 timestampMs) const
+{
+    return bucketStart(timestampMs) + result.bucketMs - 1;
+}
+
+QueryAccumulator &QueryBuilder::at(qint64 timestampMs)
+{
+    const qint64 start = bucketStart(timestampMs);
+    if (start != currentStart) {
+        finish();
+        currentStart = start;
+    }
+    return current;
+}
+
+void QueryBuilder::finish()
+{
+    if (current.count > 0)
+        result.buckets.append({ currentStart, current.count,
+                                current.result(result.aggregate) });
+    current = QueryAccumulator();
+}
+
+// ================================================================
+//  Parsing / Output
+// ================================================================
+
+bool SeriesQuery::parseAggregate(const QString &text, QueryAggregate &out)
+{
+    const QString t = text.trimmed().toLower();
+    if (t == "min")                      out = QueryAggregate::Min;
+    else if (t == "max")                 out = QueryAggregate::Max;
+    else if (t == "mean" || t == "avg")  out = QueryAggregate::Mean;
+    else if (t == "sum")                 out = QueryAggregate::Sum;
+    else if (t == "count")               out = QueryAggregate::Count;
+    else if (t == "last")                out = QueryAggregate::Last;
+    else
+        return false;
+    return true;
+}
+
+QString SeriesQuery::aggregateName(QueryAggregate aggregate)
+{
+    switch (aggregate) {
+    case QueryAggregate::Min:   return "min";
+    case QueryAggregate::Max:   return "max";
+    case QueryAggregate::Mean:  return "mean";
+    case QueryAggregate::Sum:   return "sum";
+    case QueryAggregate::Count: return "count";
+    case QueryAggregate::Last:  return "last";
+    }
+    return QString();
+}
+
+bool SeriesQuery::parseDuration(const QString &text, qint64 &ms)
+{
+    QString t = text.trimmed();
+    qint64 unit = 1;
+    if (t.endsWith('s'))      unit = 1000;
+    else if (t.endsWith('m')) unit = 60 * 1000;
+    else if (t.endsWith('h')) unit = 3600 * 1000;
+    else if (t.endsWith('d')) unit = 24 * 3600 * 1000LL;
+    if (unit != 1)
+        t.chop(1);
+
+    bool ok = false;
+    const qint64 n = t.toLongLong(&ok);
+    if (!ok)
+        return false;
+    ms = n * unit;
+    return true;
+}
+
+QByteArray SeriesQuery::toJson(const QueryResult &result)
+{
+    QByteArray out;
+    out.reserve(128 + result.buckets.size() * 32);
+
+    out += "{\"series\":\"" + result.series.toUtf8() + "\"";
+    out += ",\"from\":" + QByteArray::number(result.fromMs);
+    out += ",\"to\":" + QByteArray::number(result.toMs);
+    out += ",\"bucketMs\":" + QByteArray::number(result.bucketMs);
+    out += ",\"aggregate\":\"" + aggregateName(result.aggregate).toUtf8() + "\"";
+    out += ",\"source\":\"" + result.source.toUtf8() + "\"";
+    out += ",\"buckets\":[";
+    for (int i = 0; i < result.buckets.size(); i++) {
+        const QueryBucket &b = result.buckets[i];
+        if (i > 0)
+            out += ',';
+        out += '[';
+        out += QByteArray::number(b.startMs);
+        out += ',';
+        // JSON has no NaN or infinity
+        out += qIsFinite(b.value) ? QByteArray::number(b.value, 'g', 10) : QByteArray("null");
+        out += ',';
+        out += QByteArray::number(b.count);
+        out += ']';
+    }
+    out += "]}";
+    return out;
+}
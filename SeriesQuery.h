@@ -0,0 +1,91 @@
+/////////////////////////////////////////////////////////////
+// SERIESQUERY.H - Bucketed Range Queries Header
+/////////////////////////////////////////////////////////////
+
+#ifndef SERIESQUERY_H
+#define SERIESQUERY_H
+
+#include <QByteArray>
+#include <QString>
+#include <QVector>
+
+enum class QueryAggregate {
+    Min,
+    Max,
+    Mean,
+    Sum,
+    Count,
+    Last
+};
+
+// One output bucket; buckets without samples are left out
+struct QueryBucket {
+    qint64  startMs;
+    quint32 count;
+    double  value;
+};
+
+struct QueryResult {
+    QString        series;
+    qint64         fromMs    = 0;     // Widened to whole buckets
+    qint64         toMs      = 0;
+    qint64         bucketMs  = 0;
+    QueryAggregate aggregate = QueryAggregate::Mean;
+    QString        source;            // "raw", or the rollup tier used
+    QVector<QueryBucket> buckets;
+};
+
+// Running min/max/sum/count/last of one bucket. Runs of decoded
+// samples, block headers and rollup buckets all merge into it.
+struct QueryAccumulator {
+    quint32 count    = 0;
+    double  minValue = 0;
+    double  maxValue = 0;
+    double  sum      = 0;
+    double  last     = 0;
+
+    // Fold a contiguous run of values, oldest first
+    void addRun(const double *values, int n);
+
+    // Fold a pre-aggregated summary (its last value only if known)
+    void addSummary(quint32 n, double min, double max, double total);
+    void addSummary(quint32 n, double min, double max, double total, double lastValue);
+
+    double result(QueryAggregate aggregate) const;
+};
+
+// Assigns time-ordered input to consecutive buckets of the result
+class QueryBuilder
+{
+public:
+    explicit QueryBuilder(QueryResult &result);
+
+    qint64 bucketStart(qint64 timestampMs) const;
+    qint64 bucketEnd(qint64 timestampMs) const;        // Last ms in the bucket
+
+    // The bucket holding timestampMs; must not go backwards
+    QueryAccumulator &at(qint64 timestampMs);
+    void finish();                                     // Emit the last bucket
+
+private:
+    QueryResult     &result;
+    qint64           currentStart = 0;
+    QueryAccumulator current;
+};
+
+class SeriesQuery
+{
+public:
+    // "min", "max", "mean" (or "avg"), "sum", "count", "last"
+    static bool    parseAggregate(const QString &text, QueryAggregate &out);
+    static QString aggregateName(QueryAggregate aggregate);
+
+    // Milliseconds, or a number with an s/m/h/d suffix ("90s", "1h")
+    static bool parseDuration(const QString &text, qint64 &ms);
+
+    // {"series":…,"from":…,"to":…,"bucketMs":…,"aggregate":…,
+    //  "source":…,"buckets":[[startMs,value,count],…]}
+    static QByteArray toJson(const QueryResult &result);
+};
+
+#endif // SERIESQUERY_H
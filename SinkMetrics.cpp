@@ -0,0 +1,248 @@
+/////////////////////////////////////////////////////////////
+// SINKMETRICS.CPP - Telemetry Pipeline Instrumentation
+/////////////////////////////////////////////////////////////
+
+#include "SinkMetrics.h"
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+
+const int LatencyHistogram::BUCKET_BOUNDS_MS[LatencyHistogram::BUCKET_COUNT - 1] = {
+    10, 25, 50, 100, 250, 500, 1000, 2500, 5000, 10000, 30000
+};
+
+void LatencyHistogram::record(qint64 ms)
+{
+    int b = 0;
+    while (b < BUCKET_COUNT - 1 && ms > BUCKET_BOUNDS_MS[b])
+        b++;
+    buckets[b]++;
+    count++;
+    sumMs += ms;
+    maxMs = qMax(maxMs, ms);
+}
+
+qint64 LatencyHistogram::quantileMs(double q) const
+{
+    if (count == 0)
+        return 0;
+
+    quint64 rank = quint64(q * count + 0.5);
+    quint64 seen = 0;
+    for (int b = 0; b < BUCKET_COUNT - 1; b++) {
+        seen += buckets[b];
+        if (seen >= rank && seen > 0)
+            return qMin<qint64>(BUCKET_BOUNDS_MS[b], maxMs);
+    }
+    return maxMs;
+}
+
+const char *TickMetrics::stageName(Stage stage)
+{
+    switch (stage) {
+    case Sense:       return "sense";
+    case Forecast:    return "forecast";
+    case Decide:      return "decide";
+    case Total:       return "total";
+    case STAGE_COUNT: break;
+    }
+    return "";
+}
+
+void TickMetrics::record(Stage stage, qint64 ms)
+{
+    stages[stage].record(ms);
+    lastMs[stage] = ms;
+}
+
+// ================================================================
+//  Prometheus text format
+// ================================================================
+
+static void appendMetric(QByteArray &out, const char *name, const SinkMetrics &s,
+                         quint64 value)
+{
+    out += name;
+    out += "{sink=\"" + s.name.toUtf8() + "\",type=\"" + s.type.toUtf8() + "\"} ";
+    out += QByteArray::number(value);
+    out += '\n';
+}
+
+static void appendFamily(QByteArray &out, const char *name, const char *type,
+                         const char *help, const QVector<SinkMetrics> &sinks,
+                         quint64 SinkMetrics::*field)
+{
+    out += QByteArray("# HELP ") + name + ' ' + help + '\n';
+    out += QByteArray("# TYPE ") + name + ' ' + type + '\n';
+    for (const SinkMetrics &s : sinks)
+        appendMetric(out, name, s, s.*field);
+}
+
+static void appendHistogram(QByteArray &out, const char *name, const QByteArray &labels,
+                            const LatencyHistogram &histogram)
+{
+    quint64 cumulative = 0;
+    for (int b = 0; b < LatencyHistogram::BUCKET_COUNT; b++) {
+        cumulative += histogram.buckets[b];
+        QByteArray le = b < LatencyHistogram::BUCKET_COUNT - 1
+            ? QByteArray::number(LatencyHistogram::BUCKET_BOUNDS_MS[b] / 1000.0)
+            : QByteArray("+Inf");
+        out += QByteArray(name) + "_bucket{" + labels + ",le=\"" + le + "\"} "
+             + QByteArray::number(cumulative) + '\n';
+    }
+    out += QByteArray(name) + "_sum{" + labels + "} "
+         + QByteArray::number(histogram.sumMs / 1000.0) + '\n';
+    out += QByteArray(name) + "_count{" + labels + "} "
+         + QByteArray::number(histogram.count) + '\n';
+}
+
+static void appendGauge(QByteArray &out, const char *name, const char *help,
+                        const QVector<SinkMetrics> &sinks, int SinkMetrics::*field)
+{
+    out += QByteArray("# HELP ") + name + ' ' + help + '\n';
+    out += QByteArray("# TYPE ") + name + " gauge\n";
+    for (const SinkMetrics &s : sinks)
+        appendMetric(out, name, s, quint64(qMax(0, s.*field)));
+}
+
+QByteArray MetricsFormat::toPrometheus(const QVector<SinkMetrics> &sinks)
+{
+    QByteArray out;
+
+    appendFamily(out, "smartstorm_sink_readings_submitted_total", "counter",
+                 "Readings handed to the sink", sinks, &SinkMetrics::readingsSubmitted);
+    appendFamily(out, "smartstorm_sink_readings_delivered_total", "counter",
+                 "Readings delivered by the sink", sinks, &SinkMetrics::readingsDelivered);
+    appendFamily(out, "smartstorm_sink_readings_reduced_total", "counter",
+                 "Readings suppressed by report-by-exception", sinks,
+                 &SinkMetrics::readingsReduced);
+    appendFamily(out, "smartstorm_sink_readings_dropped_total", "counter",
+                 "Readings dropped (rejected or overflow)", sinks,
+                 &SinkMetrics::readingsDropped);
+    appendFamily(out, "smartstorm_sink_bytes_sent_total", "counter",
+                 "Body bytes written or uploaded", sinks, &SinkMetrics::bytesSent);
+    appendFamily(out, "smartstorm_sink_requests_total", "counter",
+                 "Requests or batch writes started", sinks, &SinkMetrics::requests);
+    appendFamily(out, "smartstorm_sink_failures_total", "counter",
+                 "Failed requests or batch writes", sinks, &SinkMetrics::failures);
+    appendFamily(out, "smartstorm_sink_retries_total", "counter",
+                 "Retries scheduled", sinks, &SinkMetrics::retries);
+    appendFamily(out, "smartstorm_sink_timeouts_total", "counter",
+                 "Requests aborted by the timeout", sinks, &SinkMetrics::timeouts);
+    appendFamily(out, "smartstorm_sink_breaker_trips_total", "counter",
+                 "Circuit breaker trips", sinks, &SinkMetrics::breakerTrips);
+
+    appendGauge(out, "smartstorm_sink_in_flight", "Requests outstanding",
+                sinks, &SinkMetrics::inFlight);
+    appendGauge(out, "smartstorm_sink_queue_depth", "Readings waiting in memory",
+                sinks, &SinkMetrics::queueDepth);
+    appendGauge(out, "smartstorm_sink_backlog", "Readings waiting on disk",
+                sinks, &SinkMetrics::backlog);
+
+    const char *hist = "smartstorm_sink_request_duration_seconds";
+    out += QByteArray("# HELP ") + hist + " Request or batch write latency\n";
+    out += QByteArray("# TYPE ") + hist + " histogram\n";
+    for (const SinkMetrics &s : sinks) {
+        QByteArray labels = "sink=\"" + s.name.toUtf8() + "\",type=\"" + s.type.toUtf8() + "\"";
+        appendHistogram(out, hist, labels, s.latency);
+    }
+    return out;
+}
+
+QByteArray MetricsFormat::toPrometheus(const TickMetrics &tick)
+{
+    QByteArray out;
+
+    out += "# HELP smartstorm_ticks_total Controller ticks finished\n"
+           "# TYPE smartstorm_ticks_total counter\n"
+           "smartstorm_ticks_total " + QByteArray::number(tick.ticks) + '\n';
+    out += "# HELP smartstorm_tick_early_decisions_total Release decided before the forecast arrived\n"
+           "# TYPE smartstorm_tick_early_decisions_total counter\n"
+           "smartstorm_tick_early_decisions_total " + QByteArray::number(tick.earlyDecisions) + '\n';
+    out += "# HELP smartstorm_tick_overruns_total Ticks skipped while the previous one ran\n"
+           "# TYPE smartstorm_tick_overruns_total counter\n"
+           "smartstorm_tick_overruns_total " + QByteArray::number(tick.overruns) + '\n';
+
+    const char *hist = "smartstorm_tick_stage_seconds";
+    out += QByteArray("# HELP ") + hist + " Time from tick start to each stage done\n";
+    out += QByteArray("# TYPE ") + hist + " histogram\n";
+    for (int stage = 0; stage < TickMetrics::STAGE_COUNT; stage++) {
+        QByteArray labels = QByteArray("stage=\"")
+                          + TickMetrics::stageName(TickMetrics::Stage(stage)) + "\"";
+        appendHistogram(out, hist, labels, tick.stages[stage]);
+    }
+    return out;
+}
+
+// ================================================================
+//  JSON
+// ================================================================
+
+static QJsonObject histogramJson(const LatencyHistogram &histogram)
+{
+    QJsonArray buckets;
+    for (int b = 0; b < LatencyHistogram::BUCKET_COUNT; b++)
+        buckets.append(double(histogram.buckets[b]));
+
+    QJsonArray bounds;
+    for (int b = 0; b < LatencyHistogram::BUCKET_COUNT - 1; b++)
+        bounds.append(LatencyHistogram::BUCKET_BOUNDS_MS[b]);
+
+    QJsonObject json;
+    json["count"]     = double(histogram.count);
+    json["sum_ms"]    = double(histogram.sumMs);
+    json["max_ms"]    = double(histogram.maxMs);
+    json["p50_ms"]    = double(histogram.quantileMs(0.50));
+    json["p95_ms"]    = double(histogram.quantileMs(0.95));
+    json["p99_ms"]    = double(histogram.quantileMs(0.99));
+    json["bounds_ms"] = bounds;
+    json["buckets"]   = buckets;
+    return json;
+}
+
+QByteArray MetricsFormat::toJson(const QVector<SinkMetrics> &sinks, const TickMetrics *tick)
+{
+    QJsonArray array;
+    for (const SinkMetrics &s : sinks) {
+        QJsonObject json;
+        json["name"]               = s.name;
+        json["type"]               = s.type;
+        json["latency"]            = histogramJson(s.latency);
+        json["readings_submitted"] = double(s.readingsSubmitted);
+        json["readings_delivered"] = double(s.readingsDelivered);
+        json["readings_reduced"]   = double(s.readingsReduced);
+        json["readings_dropped"]   = double(s.readingsDropped);
+        json["bytes_sent"]         = double(s.bytesSent);
+        json["requests"]           = double(s.requests);
+        json["failures"]           = double(s.failures);
+        json["retries"]            = double(s.retries);
+        json["timeouts"]           = double(s.timeouts);
+        json["breaker_trips"]      = double(s.breakerTrips);
+        json["in_flight"]          = s.inFlight;
+        json["queue_depth"]        = s.queueDepth;
+        json["backlog"]            = s.backlog;
+        if (!s.breaker.isEmpty())
+            json["breaker"] = s.breaker;
+        array.append(json);
+    }
+
+    QJsonObject root;
+    root["sinks"] = array;
+
+    if (tick) {
+        QJsonObject stages;
+        for (int stage = 0; stage < TickMetrics::STAGE_COUNT; stage++) {
+            QJsonObject json = histogramJson(tick->stages[stage]);
+            json["last_ms"] = double(tick->lastMs[stage]);
+            stages[TickMetrics::stageName(TickMetrics::Stage(stage))] = json;
+        }
+
+        QJsonObject json;
+        json["ticks"]           = double(tick->ticks);
+        json["early_decisions"] = double(tick->earlyDecisions);
+        json["overruns"]        = double(tick->overruns);
+        json["stages"]          = stages;
+        root["tick"] = json;
+    }
+    return QJsonDocument(root).toJson(QJsonDocument::Compact);
+}
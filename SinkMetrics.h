@@ -0,0 +1,87 @@
+/////////////////////////////////////////////////////////////
+// SINKMETRICS.H - Telemetry Pipeline Instrumentation
+/////////////////////////////////////////////////////////////
+
+#ifndef SINKMETRICS_H
+#define SINKMETRICS_H
+
+#include <QByteArray>
+#include <QString>
+#include <QVector>
+
+// Request latency histogram with fixed buckets from 10 ms to 30 s.
+// Cheap to record into and to copy, so sinks can hand out
+// snapshots across threads.
+class LatencyHistogram
+{
+public:
+    static const int BUCKET_COUNT = 12;
+    static const int BUCKET_BOUNDS_MS[BUCKET_COUNT - 1];   // Last bucket is +Inf
+
+    void record(qint64 ms);
+
+    // Upper bound of the bucket holding the given quantile (0..1);
+    // the largest sample seen if it lands in the +Inf bucket
+    qint64 quantileMs(double q) const;
+
+    quint64 buckets[BUCKET_COUNT] = {};
+    quint64 count = 0;
+    qint64  sumMs = 0;
+    qint64  maxMs = 0;
+};
+
+// Point-in-time view of one sink
+struct SinkMetrics {
+    QString name;
+    QString type;                    // "http", "file", "unix", "stdout"
+
+    LatencyHistogram latency;        // Per request (HTTP) or batch write (local)
+
+    quint64 readingsSubmitted = 0;
+    quint64 readingsDelivered = 0;
+    quint64 readingsReduced   = 0;   // Suppressed by report-by-exception
+    quint64 readingsDropped   = 0;   // Rejected by the server or queue overflow
+    quint64 bytesSent         = 0;
+    quint64 requests          = 0;
+    quint64 failures          = 0;
+    quint64 retries           = 0;
+    quint64 timeouts          = 0;
+    quint64 breakerTrips      = 0;
+
+    int inFlight   = 0;              // Requests outstanding
+    int queueDepth = 0;              // Readings waiting in memory
+    int backlog    = 0;              // Readings waiting on disk
+    QString breaker;                 // "closed", "open", "half-open" (HTTP only)
+};
+
+// The controller's tick pipeline: how long after the tick started
+// each stage was done
+struct TickMetrics {
+    enum Stage {
+        Sense,                       // Readings back from the sensor thread
+        Forecast,                    // Forecast parsed (or failed)
+        Decide,                      // Release decision taken
+        Total,                       // Everything recorded
+        STAGE_COUNT
+    };
+    static const char *stageName(Stage stage);
+
+    void record(Stage stage, qint64 ms);
+
+    LatencyHistogram stages[STAGE_COUNT];
+    qint64  lastMs[STAGE_COUNT] = {};
+    quint64 ticks          = 0;      // Finished
+    quint64 earlyDecisions = 0;      // Decided before the forecast arrived
+    quint64 overruns       = 0;      // Skipped: the previous tick was still running
+};
+
+// Machine-readable renderings served on the local HTTP endpoint
+class MetricsFormat
+{
+public:
+    static QByteArray toPrometheus(const QVector<SinkMetrics> &sinks);
+    static QByteArray toPrometheus(const TickMetrics &tick);
+    static QByteArray toJson(const QVector<SinkMetrics> &sinks, const TickMetrics *tick = nullptr);
+};
+
+#endif // SINKMETRICS_H
@@ -0,0 +1,59 @@
+# Controller core: everything the control loop needs, on QtCore
+# and QtNetwork only. Included by SmartRainHarvest.pro (dashboard)
+# and SmartRainHarvestd.pro (headless daemon); nothing listed here
+# may include a QtGui, QtWidgets or QtCharts header.
+
+QT += core network
+
+INCLUDEPATH += $$PWD
+
+SOURCES += \
+    $$PWD/ControllerSnapshot.cpp \
+    $$PWD/DatabaseWriter.cpp \
+    $$PWD/DistanceSensor.cpp \
+    $$PWD/GorillaCodec.cpp \
+    $$PWD/HistoryExporter.cpp \
+    $$PWD/HttpSink.cpp \
+    $$PWD/LocalHttpServer.cpp \
+    $$PWD/LocalSinks.cpp \
+    $$PWD/MoistureSensor.cpp \
+    $$PWD/RainController.cpp \
+    $$PWD/ReadingSerializer.cpp \
+    $$PWD/RollupRing.cpp \
+    $$PWD/SeriesQuery.cpp \
+    $$PWD/SinkMetrics.cpp \
+    $$PWD/StreamReducer.cpp \
+    $$PWD/TelemetrySink.cpp \
+    $$PWD/TimeSeriesStore.cpp \
+    $$PWD/UploadQueue.cpp \
+    $$PWD/WireCodec.cpp \
+    $$PWD/noaaweatherfetcher.cpp
+
+HEADERS += \
+    $$PWD/ControllerSnapshot.h \
+    $$PWD/DatabaseWriter.h \
+    $$PWD/DistanceSensor.h \
+    $$PWD/GorillaCodec.h \
+    $$PWD/HistoryExporter.h \
+    $$PWD/HttpSink.h \
+    $$PWD/LocalHttpServer.h \
+    $$PWD/LocalSinks.h \
+    $$PWD/MoistureSensor.h \
+    $$PWD/RainController.h \
+    $$PWD/ReadingSerializer.h \
+    $$PWD/RingHistory.h \
+    $$PWD/RollupRing.h \
+    $$PWD/SensorReading.h \
+    $$PWD/SeriesQuery.h \
+    $$PWD/SinkMetrics.h \
+    $$PWD/StreamReducer.h \
+    $$PWD/TelemetrySink.h \
+    $$PWD/TimeSeriesStore.h \
+    $$PWD/TokenBucket.h \
+    $$PWD/UploadQueue.h \
+    $$PWD/WireCodec.h \
+    $$PWD/noaaweatherfetcher.h
+
+contains(DEFINES, RasPi) {
+    LIBS += -lwiringPi
+}
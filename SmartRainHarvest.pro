@@ -2,7 +2,7 @@ QT       += core gui
 QT       += charts
 
 greaterThan(QT_MAJOR_VERSION, 4):
-QT += widgets network charts
+QT += widgets network charts svg
 
 CONFIG += c++11
 
@@ -13,30 +13,28 @@ CONFIG += c++11
 DEFINES += RasPi
 DEFINES += Qt5
 
+# Control loop, sensors, fetcher, store and uplink
+include(SmartRainCore.pri)
+
+# Dashboard
 SOURCES += \
-    DatabaseWriter.cpp \
-    DistanceSensor.cpp \
-    MoistureSensor.cpp \
+    DashboardModel.cpp \
+    Downsampler.cpp \
+    MinMaxPyramid.cpp \
     chartcontainer.cpp \
     main.cpp \
-    noaaweatherfetcher.cpp \
     smartrainharvest.cpp
 
 HEADERS += \
-    DatabaseWriter.h \
-    DistanceSensor.h \
-    MoistureSensor.h \
+    DashboardModel.h \
+    Downsampler.h \
+    MinMaxPyramid.h \
     chartcontainer.h \
-    noaaweatherfetcher.h \
     smartrainharvest.h
 
 FORMS += \
     smartrainharvest.ui
 
-contains(DEFINES, RasPi) {
-    LIBS += -lwiringPi
-}
-
 # Default rules for deployment.
 qnx: target.path = /tmp/$${TARGET}/bin
 else: unix:!android: target.path = /opt/$${TARGET}/bin
@@ -0,0 +1,24 @@
+# Headless controller: the control core under QCoreApplication,
+# without QtGui, QtWidgets or QtCharts. Build beside the dashboard
+# (qmake SmartRainHarvestd.pro) and run as a service; it uses the
+# dashboard's data directory, snapshot and HTTP port.
+
+QT       = core network
+
+CONFIG += c++11 console
+CONFIG -= app_bundle
+
+TARGET = smartrainharvestd
+
+DEFINES += RasPi
+DEFINES += Qt5
+
+include(SmartRainCore.pri)
+
+SOURCES += \
+    daemon.cpp
+
+# Default rules for deployment.
+qnx: target.path = /tmp/$${TARGET}/bin
+else: unix:!android: target.path = /opt/$${TARGET}/bin
+!isEmpty(target.path): INSTALLS += target
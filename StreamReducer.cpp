@@ -0,0 +1,78 @@
+/////////////////////////////////////////////////////////////
+// STREAMREDUCER.CPP - Report-by-Exception Stream Reducer
+/////////////////////////////////////////////////////////////
+
+#include "StreamReducer.h"
+#include <QDateTime>
+#include <QtMath>
+
+void StreamReducer::setDeadband(const QString &sensorId, double deadband)
+{
+    deadbands[sensorId] = deadband;
+}
+
+// Pass a live reading only if it is an exception — first reading,
+// change beyond the deadband, or heartbeat due
+bool StreamReducer::acceptLive(const SensorReading &reading)
+{
+    auto it = exceptionState.find(reading.sensorId);
+    if (it != exceptionState.end()) {
+        double deadband = deadbands.value(reading.sensorId, 0.0);
+        bool changed    = qAbs(reading.value - it->lastValue) > deadband;
+        // 1 s of slack so a heartbeat that lines up with the tick
+        // interval isn't pushed back a whole tick by timer jitter
+        bool heartbeat  = reading.timestampMs - it->lastSentMs + 1000
+                          >= qint64(heartbeatInterval) * 1000;
+        if (!changed && !heartbeat)
+            return false;
+    }
+
+    ExceptionState &st = exceptionState[reading.sensorId];
+    st.lastValue  = reading.value;
+    st.lastSentMs = reading.timestampMs;
+    return true;
+}
+
+// The new or changed points of a forecast run plus its run marker
+QVector<SensorReading> StreamReducer::forecastDelta(const QString &sensorId,
+                                                    const QString &unit,
+                                                    const QVector<WeatherData> &weatherData)
+{
+    QVector<SensorReading> out;
+    if (weatherData.isEmpty())
+        return out;
+
+    QHash<qint64, qint64> &previous = lastForecast[sensorId];
+    QHash<qint64, qint64> current;
+    current.reserve(weatherData.size());
+
+    SensorReading reading;
+    reading.sensorId = sensorId;
+    reading.unit     = unit;
+    reading.priority = UploadPriority::Forecast;
+
+    for (const auto &data : weatherData) {
+        qint64 validTime = data.timestamp.toMSecsSinceEpoch();
+        qint64 hundredths = qRound64(data.value * 100.0);
+        current.insert(validTime, hundredths);
+
+        auto it = previous.constFind(validTime);
+        if (it == previous.constEnd() || it.value() != hundredths) {
+            reading.timestampMs = validTime;
+            reading.value       = data.value;
+            out.append(reading);
+        }
+    }
+
+    // Only remember this run's points, so valid times that have
+    // dropped off the front of the forecast don't pile up
+    previous.swap(current);
+
+    reading.sensorId    = sensorId + "_run";
+    reading.unit        = "points";
+    reading.timestampMs = QDateTime::currentMSecsSinceEpoch();
+    reading.value       = weatherData.size();
+    out.append(reading);
+
+    return out;
+}
@@ -0,0 +1,52 @@
+/////////////////////////////////////////////////////////////
+// STREAMREDUCER.H - Report-by-Exception Stream Reducer Header
+/////////////////////////////////////////////////////////////
+
+#ifndef STREAMREDUCER_H
+#define STREAMREDUCER_H
+
+#include <QHash>
+#include <QString>
+#include <QVector>
+
+#include "SensorReading.h"
+#include "noaaweatherfetcher.h"
+
+// Cuts a telemetry stream down to what a server needs to rebuild
+// it. Each reduced sink owns one, so its state tracks exactly what
+// that sink has been sent.
+//
+// Live readings use report-by-exception: a reading passes when it
+// moves more than its sensor's deadband away from the last passed
+// value, or when heartbeatInterval has passed since then. The
+// server rebuilds the series by holding each value until the next
+// one arrives; a gap longer than the heartbeat means the device
+// was offline. A deadband of 0 passes every change (valve edges).
+//
+// Forecasts pass only the points that are new or changed since the
+// last run, followed by a run marker ("<sensorId>_run", value =
+// points in the run); points the server didn't get are unchanged.
+class StreamReducer
+{
+public:
+    void setDeadband(const QString &sensorId, double deadband);
+    int heartbeatInterval = 6 * 3600;   // seconds — max gap between readings
+
+    bool acceptLive(const SensorReading &reading);
+    QVector<SensorReading> forecastDelta(const QString &sensorId, const QString &unit,
+                                         const QVector<WeatherData> &weatherData);
+
+private:
+    struct ExceptionState {
+        double lastValue  = 0;
+        qint64 lastSentMs = 0;
+    };
+    QHash<QString, double>         deadbands;
+    QHash<QString, ExceptionState> exceptionState;  // Last passed reading per sensor
+
+    // Last passed value per (sensor, valid time), in hundredths
+    // to match the precision sent on the wire
+    QHash<QString, QHash<qint64, qint64>> lastForecast;
+};
+
+#endif // STREAMREDUCER_H
@@ -0,0 +1,98 @@
+/////////////////////////////////////////////////////////////
+// TELEMETRYSINK.CPP - Buffered Sink Implementation
+/////////////////////////////////////////////////////////////
+
+#include "TelemetrySink.h"
+#include <QElapsedTimer>
+#include <QMutexLocker>
+
+BufferedSink::BufferedSink(const QString &name, QObject *parent)
+    : TelemetrySink(name, parent)
+{
+    retryTimer = new QTimer(this);
+    retryTimer->setSingleShot(true);
+    connect(retryTimer, &QTimer::timeout, this, &BufferedSink::flush);
+}
+
+void BufferedSink::submit(const SensorReading &reading)
+{
+    QMutexLocker lock(&mutex);
+    pending.append(reading);
+    stats.readingsSubmitted++;
+    trimLocked();
+
+    // One queued flush per batch, run on the sink's own thread
+    if (!flushScheduled) {
+        flushScheduled = true;
+        QMetaObject::invokeMethod(this, "flush", Qt::QueuedConnection);
+    }
+}
+
+quint64 BufferedSink::dropped() const
+{
+    QMutexLocker lock(&mutex);
+    return droppedCount;
+}
+
+SinkMetrics BufferedSink::metrics() const
+{
+    QMutexLocker lock(&mutex);
+    SinkMetrics m = stats;
+    m.name            = name();
+    m.type            = type();
+    m.readingsDropped = droppedCount;
+    m.queueDepth      = pending.size();
+    return m;
+}
+
+void BufferedSink::flush()
+{
+    QVector<SensorReading> batch;
+    {
+        QMutexLocker lock(&mutex);
+        batch.swap(pending);
+        flushScheduled = false;
+    }
+    if (batch.isEmpty())
+        return;
+
+    QElapsedTimer timer;
+    timer.start();
+    int written = writeBatch(batch);
+
+    QMutexLocker lock(&mutex);
+    stats.requests++;
+    stats.latency.record(timer.elapsed());
+    if (written > 0) {
+        // Local sinks write a batch all or nothing, so what is in
+        // the serializer is exactly what went out
+        stats.readingsDelivered += written;
+        stats.bytesSent += serializer.bytes().size();
+    }
+    if (written >= batch.size())
+        return;
+
+    // Put the unwritten tail back in front of anything newer
+    stats.failures++;
+    stats.retries++;
+    pending = batch.mid(qMax(written, 0)) + pending;
+    trimLocked();
+    if (!retryTimer->isActive())
+        retryTimer->start(retryIntervalMs);
+}
+
+// One last flush; whatever the destination still refuses is lost
+void BufferedSink::drain()
+{
+    retryTimer->stop();
+    flush();
+}
+
+void BufferedSink::trimLocked()
+{
+    int excess = pending.size() - maxQueued;
+    if (excess > 0) {
+        pending.remove(0, excess);
+        droppedCount += excess;
+    }
+}
@@ -0,0 +1,96 @@
+/////////////////////////////////////////////////////////////
+// TELEMETRYSINK.H - Telemetry Sink Interface
+/////////////////////////////////////////////////////////////
+
+#ifndef TELEMETRYSINK_H
+#define TELEMETRYSINK_H
+
+#include <QObject>
+#include <QMutex>
+#include <QTimer>
+#include <QVector>
+
+#include "SensorReading.h"
+#include "ReadingSerializer.h"
+#include "SinkMetrics.h"
+
+// A destination for sensor readings. DatabaseWriter fans every
+// reading out to all of its sinks; each sink queues readings on
+// its own, so a slow or dead sink never holds up the others.
+class TelemetrySink : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit TelemetrySink(const QString &name, QObject *parent = nullptr)
+        : QObject(parent), sinkName(name) {}
+    virtual ~TelemetrySink() {}
+
+    QString name() const { return sinkName; }
+    virtual QString type() const = 0;
+
+    // Hand over a reading. Must return quickly — the sink queues
+    // it and delivers on its own schedule.
+    virtual void submit(const SensorReading &reading) = 0;
+
+    // Sinks doing blocking I/O ask for a thread of their own
+    virtual bool wantsOwnThread() const { return false; }
+
+    // Deliver what is still queued, before shutdown. Runs on the
+    // sink's own thread and may block briefly.
+    virtual void drain() {}
+
+    // Snapshot of the sink's counters, for the thread that owns
+    // the DatabaseWriter (threaded sinks lock internally)
+    virtual SinkMetrics metrics() const = 0;
+
+private:
+    QString sinkName;
+};
+
+// Base for local sinks: a bounded in-memory queue drained in
+// batches on the sink's own thread. submit() is thread-safe.
+// When the queue is full the oldest readings are dropped.
+class BufferedSink : public TelemetrySink
+{
+    Q_OBJECT
+
+public:
+    explicit BufferedSink(const QString &name, QObject *parent = nullptr);
+
+    void submit(const SensorReading &reading) override;
+    bool wantsOwnThread() const override { return true; }
+    SinkMetrics metrics() const override;
+    void drain() override;
+
+    int maxQueued = 10000;
+    quint64 dropped() const;
+
+public slots:
+    void flush();
+
+protected:
+    // Write as much of the batch as possible and return how many
+    // readings were written; the rest is retried later
+    virtual int writeBatch(const QVector<SensorReading> &batch) = 0;
+
+    int retryIntervalMs = 1000;
+
+    // Scratch buffer for writeBatch(), reused across batches
+    ReadingSerializer serializer;
+
+private:
+    mutable QMutex mutex;
+    QVector<SensorReading> pending;
+    bool    flushScheduled = false;
+    quint64 droppedCount   = 0;
+    QTimer *retryTimer;
+
+    // Everything but the queue depth and drop count, which are
+    // read straight from the queue state
+    SinkMetrics stats;
+
+    void trimLocked();
+};
+
+#endif // TELEMETRYSINK_H
@@ -0,0 +1,795 @@
+/////////////////////////////////////////////////////////////
+// TIMESERIESSTORE.CPP - On-Device Time-Series Store
+/////////////////////////////////////////////////////////////
+
+#include "TimeSeriesStore.h"
+#include "GorillaCodec.h"
+#include <QDateTime>
+#include <QDebug>
+#include <QDir>
+#include <QFileInfo>
+#include <algorithm>
+#include <cstring>
+#ifdef Q_OS_UNIX
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+// On-disk layout (host byte order; the store never leaves the device)
+static const char    SEGMENT_MAGIC[4]   = { 'S', 'R', 'T', 'S' };
+static const quint16 SEGMENT_VERSION_V1 = 1;   // 32-byte block headers, raw columns
+static const quint16 SEGMENT_VERSION    = 2;   // 64-byte block headers, Gorilla
+static const int     BLOCK_BYTES        = 4096;
+static const int     SEGMENT_BLOCKS     = 1024;                 // 4 MiB per segment
+static const qint64  SEGMENT_BYTES      = qint64(BLOCK_BYTES) * SEGMENT_BLOCKS;
+
+// Raw data expires a segment at a time, so a segment holds at most
+// one UTC day
+static const qint64  DAY_MS             = 24 * 3600 * 1000LL;
+
+static const quint8  BLOCK_RAW     = 0;   // Plain timestamp and value columns (v1)
+static const quint8  BLOCK_GORILLA = 1;   // GorillaCodec bit stream
+
+struct SegmentHeader {          // Block 0 of every segment
+    char    magic[4];
+    quint16 version;
+    quint16 blockBytes;
+    quint32 blockCount;
+    quint32 reserved;
+    qint64  createdMs;
+};
+
+struct BlockHeader {            // Start of every data block
+    quint32 count;              // Committed samples — bumped last
+    quint32 checksum;           // FNV-1a over the committed samples
+    qint64  firstMs;
+    qint64  lastMs;
+    quint8  encoding;
+    quint8  reserved[3];
+    // v2 only: v1 blocks end their header here
+    quint32 usedBits;           // Length of the Gorilla stream
+    double  minValue;
+    double  maxValue;
+    double  sum;
+    quint8  reserved2[8];
+};
+static_assert(sizeof(BlockHeader) == 64, "block header must stay 64 bytes");
+
+static const int V1_HEADER_BYTES = 32;
+static const int RAW_SAMPLES =
+    (BLOCK_BYTES - V1_HEADER_BYTES) / int(sizeof(qint64) + sizeof(double));
+static const quint32 STREAM_BITS = (BLOCK_BYTES - sizeof(BlockHeader)) * 8;
+
+static inline const qint64 *rawTimes(const BlockHeader *h)
+{
+    return reinterpret_cast<const qint64 *>(reinterpret_cast<const uchar *>(h)
+                                            + V1_HEADER_BYTES);
+}
+
+static inline const double *rawValues(const BlockHeader *h)
+{
+    return reinterpret_cast<const double *>(reinterpret_cast<const uchar *>(h)
+                                            + V1_HEADER_BYTES + RAW_SAMPLES * sizeof(qint64));
+}
+
+static inline uchar *stream(BlockHeader *h)
+{
+    return reinterpret_cast<uchar *>(h) + sizeof(BlockHeader);
+}
+
+static inline const uchar *stream(const BlockHeader *h)
+{
+    return reinterpret_cast<const uchar *>(h) + sizeof(BlockHeader);
+}
+
+// FNV-1a, extended one sample at a time as samples are appended
+static const quint32 CHECKSUM_SEED = 2166136261u;
+
+static quint32 checksumSample(quint32 h, qint64 timestampMs, double value)
+{
+    uchar bytes[16];
+    std::memcpy(bytes, &timestampMs, 8);
+    std::memcpy(bytes + 8, &value, 8);
+    for (uchar b : bytes) {
+        h ^= b;
+        h *= 16777619u;
+    }
+    return h;
+}
+
+// msync a range of a mapping (no-op off Unix)
+static void syncMapped(uchar *from, qint64 length)
+{
+#ifdef Q_OS_UNIX
+    quintptr page  = quintptr(::sysconf(_SC_PAGESIZE));
+    quintptr start = quintptr(from) & ~(page - 1);
+    ::msync(reinterpret_cast<void *>(start), quintptr(from) + length - start, MS_SYNC);
+#else
+    Q_UNUSED(from);
+    Q_UNUSED(length);
+#endif
+}
+
+// fsync a directory so a new file inside it is durable
+static void fsyncDirectory(const QString &dirPath)
+{
+#ifdef Q_OS_UNIX
+    int fd = ::open(QFile::encodeName(dirPath).constData(), O_RDONLY);
+    if (fd >= 0) {
+        ::fsync(fd);
+        ::close(fd);
+    }
+#else
+    Q_UNUSED(dirPath);
+#endif
+}
+
+struct TimeSeriesStore::Segment {
+    QFile  file;
+    uchar *map        = nullptr;
+    int    usedBlocks = 0;          // Data blocks holding samples (from block 1)
+    bool   writable   = false;
+    quint16 version   = SEGMENT_VERSION;
+    qint64 firstMs    = 0;
+    qint64 lastMs     = 0;
+
+    // Sparse time index: first timestamp of each used block, so a
+    // range lookup doesn't touch one mapped page per block header
+    QVector<qint64> blockStart;
+
+    BlockHeader *block(int i) const
+    {
+        return reinterpret_cast<BlockHeader *>(map + qint64(i) * BLOCK_BYTES);
+    }
+
+    // First block that can hold samples at or after fromMs
+    int findBlock(qint64 fromMs) const
+    {
+        const qint64 *begin = blockStart.constData();
+        const int n = int(std::upper_bound(begin, begin + blockStart.size(), fromMs) - begin);
+        return qMax(1, n);
+    }
+};
+
+struct TimeSeriesStore::Series {
+    QString dir;
+    QVector<Segment*> segments;     // Oldest first; only the last is written
+    bool    hasSamples = false;
+    qint64  lastMs     = 0;
+    GorillaState tail;              // Encoder state of the tail block
+    int     dirtyFirst = 0;         // Tail-segment blocks written since sync
+    int     dirtyLast  = -1;
+    RollupRing *rollups[ROLLUP_TIERS] = {};
+
+    ~Series() { qDeleteAll(rollups, rollups + ROLLUP_TIERS); }
+};
+
+TimeSeriesStore::TimeSeriesStore(const QString &rootDir, QObject *parent)
+    : QObject(parent)
+    , root(rootDir)
+{
+    syncTimer = new QTimer(this);
+    syncTimer->setSingleShot(true);
+    connect(syncTimer, &QTimer::timeout, this, &TimeSeriesStore::sync);
+}
+
+TimeSeriesStore::~TimeSeriesStore()
+{
+    sync();
+    for (Series *s : seriesByName) {
+        for (Segment *seg : s->segments)
+            closeSegment(seg);
+        delete s;
+    }
+}
+
+// ================================================================
+//  Startup
+// ================================================================
+
+bool TimeSeriesStore::open(OpenMode mode)
+{
+    readOnly = mode == ReadOnly;
+    if (!readOnly && !QDir().mkpath(root)) {
+        qWarning() << "TimeSeriesStore: cannot create" << root;
+        return false;
+    }
+
+    const QStringList names = QDir(root).entryList(QDir::Dirs | QDir::NoDotAndDotDot);
+    for (const QString &name : names)
+        loadSeries(name);
+    return true;
+}
+
+TimeSeriesStore::Series *TimeSeriesStore::loadSeries(const QString &name)
+{
+    Series *s = new Series;
+    s->dir = root + "/" + name;
+
+    const QStringList files = QDir(s->dir).entryList(QStringList() << "*.seg",
+                                                     QDir::Files, QDir::Name);
+    for (int i = 0; i < files.size(); i++) {
+        Segment *seg = openSegment(s->dir + "/" + files[i],
+                                   !readOnly && i == files.size() - 1);
+        if (seg)
+            s->segments.append(seg);
+    }
+
+    recoverTail(s);
+    if (!readOnly) {
+        if (s->hasSamples)
+            expireSegments(s, s->lastMs);
+        openRollups(s);
+    }
+    seriesByName.insert(name, s);
+    return s;
+}
+
+// Map a segment and find how many blocks are in use. Only the
+// tail segment is mapped writable.
+TimeSeriesStore::Segment *TimeSeriesStore::openSegment(const QString &path, bool tail)
+{
+    Segment *seg = new Segment;
+    seg->file.setFileName(path);
+
+    if (!seg->file.open(tail ? QIODevice::ReadWrite : QIODevice::ReadOnly)
+        || seg->file.size() < SEGMENT_BYTES
+        || !(seg->map = seg->file.map(0, SEGMENT_BYTES))) {
+        qWarning() << "TimeSeriesStore: cannot map" << path << seg->file.errorString();
+        delete seg;
+        return nullptr;
+    }
+
+    const SegmentHeader *hdr = reinterpret_cast<const SegmentHeader *>(seg->map);
+    if (std::memcmp(hdr->magic, SEGMENT_MAGIC, 4) != 0 || hdr->version > SEGMENT_VERSION
+        || hdr->version < SEGMENT_VERSION_V1) {
+        qWarning() << "TimeSeriesStore: skipping unrecognised segment" << path;
+        closeSegment(seg);
+        return nullptr;
+    }
+
+    // Older segments stay readable, but new samples go to a new one
+    seg->version  = hdr->version;
+    seg->writable = tail && seg->version == SEGMENT_VERSION;
+
+    while (seg->usedBlocks + 1 < SEGMENT_BLOCKS && seg->block(seg->usedBlocks + 1)->count > 0) {
+        seg->usedBlocks++;
+        seg->blockStart.append(seg->block(seg->usedBlocks)->firstMs);
+    }
+
+    if (seg->usedBlocks > 0) {
+        seg->firstMs = seg->block(1)->firstMs;
+        seg->lastMs  = seg->block(seg->usedBlocks)->lastMs;
+    }
+    return seg;
+}
+
+// Decode the last written block to resume appending to it. If its
+// checksum doesn't match (torn write at power loss), cut it back
+// to its last sane sample; a block left empty is dropped and the
+// one before it becomes the tail.
+void TimeSeriesStore::recoverTail(Series *s)
+{
+    Segment *seg = s->segments.isEmpty() ? nullptr : s->segments.last();
+
+    while (seg && seg->writable && seg->usedBlocks > 0) {
+        BlockHeader *h = seg->block(seg->usedBlocks);
+        const qint64 floor = seg->usedBlocks > 1 ? seg->block(seg->usedBlocks - 1)->lastMs
+                                                 : h->firstMs;
+
+        // Decode while timestamps still run forward
+        GorillaDecoder decoder(stream(h), STREAM_BITS);
+        GorillaState good;
+        quint32 sum = CHECKSUM_SEED;
+        double  minValue = 0, maxValue = 0, total = 0;
+        qint64  t, last = floor;
+        double  v;
+        while (good.count < h->count && decoder.next(t, v) && t >= last) {
+            minValue = good.count == 0 ? v : qMin(minValue, v);
+            maxValue = good.count == 0 ? v : qMax(maxValue, v);
+            total   += v;
+            sum      = checksumSample(sum, t, v);
+            last     = t;
+            good     = decoder.state();
+        }
+
+        if (good.count != h->count || good.bitPos != h->usedBits || sum != h->checksum) {
+            qWarning() << "TimeSeriesStore: torn block in" << seg->file.fileName()
+                       << "- kept" << good.count << "of" << h->count << "samples";
+
+            // Clear everything past the last good bit, so appends
+            // can OR into a zero-filled stream again
+            uchar *bits = stream(h);
+            quint32 byte = good.bitPos / 8;
+            if (good.bitPos % 8) {
+                bits[byte] &= uchar(0xFF << (8 - good.bitPos % 8));
+                byte++;
+            }
+            std::memset(bits + byte, 0, STREAM_BITS / 8 - byte);
+
+            h->usedBits = good.bitPos;
+            h->checksum = sum;
+            h->minValue = minValue;
+            h->maxValue = maxValue;
+            h->sum      = total;
+            h->lastMs   = good.count > 0 ? last : 0;
+            h->count    = good.count;
+            syncMapped(reinterpret_cast<uchar *>(h), BLOCK_BYTES);
+        }
+
+        if (good.count > 0) {
+            s->tail = good;
+            seg->lastMs = h->lastMs;
+            break;
+        }
+        seg->usedBlocks--;
+        seg->blockStart.removeLast();
+        seg->lastMs = seg->usedBlocks > 0 ? seg->block(seg->usedBlocks)->lastMs : 0;
+    }
+
+    // Newest sample across all segments
+    for (int i = s->segments.size() - 1; i >= 0; i--) {
+        if (s->segments[i]->usedBlocks > 0) {
+            s->hasSamples = true;
+            s->lastMs = s->segments[i]->lastMs;
+            break;
+        }
+    }
+}
+
+// Map the series' rollup rings and fold in the raw samples they
+// missed: those after their last sync, or all of them (within the
+// tier's retention) for a ring that is new
+void TimeSeriesStore::openRollups(Series *s)
+{
+    static const char *const names[ROLLUP_TIERS] = { "minute", "hour", "day" };
+    const int days[ROLLUP_TIERS] = { minuteRetentionDays, hourRetentionDays, dayRetentionDays };
+
+    qint64 after[ROLLUP_TIERS];
+    qint64 oldest = s->lastMs;
+    for (int t = 0; t < ROLLUP_TIERS; t++) {
+        const qint64 width = rollupWidthMs(RollupTier(t));
+        RollupRing *ring = new RollupRing(width, int(qMax<qint64>(1, days[t] * DAY_MS / width)));
+        if (!ring->open(s->dir + "/" + names[t] + ".rollup")) {
+            delete ring;
+            after[t] = s->lastMs;
+            continue;
+        }
+        s->rollups[t] = ring;
+
+        if (s->hasSamples) {
+            const qint64 covered = ring->resume(s->lastMs);
+            after[t] = covered > 0 ? covered : s->lastMs - ring->retentionMs();
+            oldest   = qMin(oldest, after[t]);
+        }
+    }
+
+    if (!s->hasSamples || oldest >= s->lastMs)
+        return;
+
+    const QVector<TimeSeriesSample> missed = readSeries(s, oldest + 1, s->lastMs);
+    for (const TimeSeriesSample &sample : missed) {
+        for (int t = 0; t < ROLLUP_TIERS; t++) {
+            if (s->rollups[t] && sample.timestampMs > after[t])
+                s->rollups[t]->add(sample.timestampMs, sample.value);
+        }
+    }
+    qDebug() << "TimeSeriesStore: caught up rollups of" << s->dir
+             << "with" << missed.size() << "samples";
+}
+
+// ================================================================
+//  Append
+// ================================================================
+
+bool TimeSeriesStore::append(const QString &series, qint64 timestampMs, double value)
+{
+    if (readOnly)
+        return false;
+
+    const QString key = seriesKey(series);
+    Series *s = seriesByName.value(key);
+    if (!s && !(s = createSeries(key)))
+        return false;
+
+    if (s->hasSamples && timestampMs < s->lastMs)
+        return false;
+
+    Segment *seg = s->segments.isEmpty() ? nullptr : s->segments.last();
+    const bool newDay = seg && seg->usedBlocks > 0
+                        && timestampMs / DAY_MS != seg->firstMs / DAY_MS;
+    BlockHeader *h = seg && seg->writable && seg->usedBlocks > 0 && !newDay
+                         ? seg->block(seg->usedBlocks) : nullptr;
+
+    // Encode into the tail block; when it is full start a new
+    // block, and a new segment when this one is full or a new
+    // day begins
+    if (!h || !GorillaCodec::append(stream(h), STREAM_BITS, s->tail, timestampMs, value)) {
+        if (!seg || !seg->writable || newDay || seg->usedBlocks + 1 >= SEGMENT_BLOCKS) {
+            if (!(seg = createSegment(s, timestampMs)))
+                return false;
+            expireSegments(s, timestampMs);
+        }
+        seg->usedBlocks++;
+        h = seg->block(seg->usedBlocks);
+        h->encoding = BLOCK_GORILLA;
+        h->firstMs  = timestampMs;
+        h->checksum = CHECKSUM_SEED;
+        h->minValue = value;
+        h->maxValue = value;
+        if (seg->usedBlocks == 1)
+            seg->firstMs = timestampMs;
+        seg->blockStart.append(timestampMs);
+
+        s->tail = GorillaState();
+        GorillaCodec::append(stream(h), STREAM_BITS, s->tail, timestampMs, value);
+    }
+
+    // Bits first, then the count that commits them
+    h->usedBits = s->tail.bitPos;
+    h->checksum = checksumSample(h->checksum, timestampMs, value);
+    h->minValue = qMin(h->minValue, value);
+    h->maxValue = qMax(h->maxValue, value);
+    h->sum     += value;
+    h->lastMs   = timestampMs;
+    h->count++;
+
+    seg->lastMs   = timestampMs;
+    s->lastMs     = timestampMs;
+    s->hasSamples = true;
+
+    for (RollupRing *ring : s->rollups) {
+        if (ring)
+            ring->add(timestampMs, value);
+    }
+
+    if (s->dirtyLast < s->dirtyFirst)
+        s->dirtyFirst = seg->usedBlocks;
+    s->dirtyLast = seg->usedBlocks;
+
+    if (!syncTimer->isActive())
+        syncTimer->start(syncIntervalMs);
+    return true;
+}
+
+TimeSeriesStore::Series *TimeSeriesStore::createSeries(const QString &name)
+{
+    Series *s = new Series;
+    s->dir = root + "/" + name;
+    if (!QDir().mkpath(s->dir)) {
+        qWarning() << "TimeSeriesStore: cannot create" << s->dir;
+        delete s;
+        return nullptr;
+    }
+    fsyncDirectory(root);
+    openRollups(s);
+    seriesByName.insert(name, s);
+    return s;
+}
+
+// Create, size and map a new tail segment. The file is sparse, so
+// blocks only take up space on the card once they are written.
+TimeSeriesStore::Segment *TimeSeriesStore::createSegment(Series *s, qint64 firstMs)
+{
+    // The old tail is sealed: flush what's left of it first
+    syncSeries(s);
+
+    const QString path = s->dir + QString("/%1.seg").arg(firstMs, 16, 10, QChar('0'));
+    Segment *seg = new Segment;
+    seg->file.setFileName(path);
+
+    if (!seg->file.open(QIODevice::ReadWrite)
+        || !seg->file.resize(SEGMENT_BYTES)
+        || !(seg->map = seg->file.map(0, SEGMENT_BYTES))) {
+        qWarning() << "TimeSeriesStore: cannot create" << path << seg->file.errorString();
+        delete seg;
+        return nullptr;
+    }
+
+    SegmentHeader *hdr = reinterpret_cast<SegmentHeader *>(seg->map);
+    std::memcpy(hdr->magic, SEGMENT_MAGIC, 4);
+    hdr->version    = SEGMENT_VERSION;
+    hdr->blockBytes = BLOCK_BYTES;
+    hdr->blockCount = SEGMENT_BLOCKS;
+    hdr->createdMs  = QDateTime::currentMSecsSinceEpoch();
+    syncMapped(seg->map, BLOCK_BYTES);
+    fsyncDirectory(s->dir);
+    seg->writable = true;
+
+    s->segments.append(seg);
+    s->dirtyFirst = 0;
+    s->dirtyLast  = -1;
+    return seg;
+}
+
+// ================================================================
+//  Sync / Close
+// ================================================================
+
+void TimeSeriesStore::sync()
+{
+    syncTimer->stop();
+    for (Series *s : seriesByName) {
+        syncSeries(s);
+        for (RollupRing *ring : s->rollups) {
+            if (ring)
+                ring->sync();
+        }
+    }
+}
+
+void TimeSeriesStore::syncSeries(Series *s)
+{
+    if (s->dirtyLast < s->dirtyFirst || s->segments.isEmpty())
+        return;
+
+    Segment *seg = s->segments.last();
+    syncMapped(reinterpret_cast<uchar *>(seg->block(s->dirtyFirst)),
+               qint64(s->dirtyLast - s->dirtyFirst + 1) * BLOCK_BYTES);
+    s->dirtyFirst = 0;
+    s->dirtyLast  = -1;
+}
+
+void TimeSeriesStore::closeSegment(Segment *seg)
+{
+    if (seg->map)
+        seg->file.unmap(seg->map);
+    seg->file.close();
+    delete seg;
+}
+
+// Drop raw segments that ended more than rawRetentionDays before
+// newestMs; their samples live on in the rollups. The tail segment
+// is never dropped.
+void TimeSeriesStore::expireSegments(Series *s, qint64 newestMs)
+{
+    if (rawRetentionDays <= 0)
+        return;
+
+    const qint64 cutoff = newestMs - rawRetentionDays * DAY_MS;
+    while (s->segments.size() > 1 && s->segments.first()->lastMs < cutoff) {
+        Segment *seg = s->segments.takeFirst();
+        const QString path = seg->file.fileName();
+        closeSegment(seg);
+        if (!QFile::remove(path))
+            qWarning() << "TimeSeriesStore: cannot expire" << path;
+    }
+}
+
+// ================================================================
+//  Read
+// ================================================================
+
+// Series names become directory names: keep them filesystem-safe
+QString TimeSeriesStore::seriesKey(const QString &name)
+{
+    QString key = name;
+    for (QChar &c : key) {
+        if (!c.isLetterOrNumber() && c != '_' && c != '-' && c != '.')
+            c = '_';
+    }
+    return key;
+}
+
+QStringList TimeSeriesStore::seriesNames() const
+{
+    QStringList names = seriesByName.keys();
+    names.sort();
+    return names;
+}
+
+qint64 TimeSeriesStore::firstTimestamp(const QString &series) const
+{
+    const Series *s = seriesByName.value(seriesKey(series));
+    if (s) {
+        for (const Segment *seg : s->segments) {
+            if (seg->usedBlocks > 0)
+                return seg->firstMs;
+        }
+    }
+    return 0;
+}
+
+qint64 TimeSeriesStore::lastTimestamp(const QString &series) const
+{
+    const Series *s = seriesByName.value(seriesKey(series));
+    return s && s->hasSamples ? s->lastMs : 0;
+}
+
+// Append a block's samples within [fromMs, toMs] to 'out'
+static void decodeBlock(quint16 version, const BlockHeader *h,
+                        qint64 fromMs, qint64 toMs, QVector<TimeSeriesSample> &out)
+{
+    if (version == SEGMENT_VERSION_V1) {
+        if (h->encoding != BLOCK_RAW)
+            return;
+        const int count = int(qMin<quint32>(h->count, quint32(RAW_SAMPLES)));
+        const qint64 *times  = rawTimes(h);
+        const double *values = rawValues(h);
+        for (int i = 0; i < count; i++) {
+            if (times[i] >= fromMs && times[i] <= toMs)
+                out.append({ times[i], values[i] });
+        }
+        return;
+    }
+
+    if (h->encoding != BLOCK_GORILLA)
+        return;
+
+    if (h->firstMs >= fromMs && h->lastMs <= toMs)
+        out.reserve(out.size() + int(h->count));
+
+    GorillaDecoder decoder(stream(h), qMin(h->usedBits, STREAM_BITS));
+    qint64 t;
+    double v;
+    for (quint32 i = 0; i < h->count && decoder.next(t, v); i++) {
+        if (t > toMs)
+            break;
+        if (t >= fromMs)
+            out.append({ t, v });
+    }
+}
+
+// Decode a whole block into timestamp and value columns
+static void decodeColumns(quint16 version, const BlockHeader *h,
+                          QVector<qint64> &times, QVector<double> &values)
+{
+    times.resize(0);
+    values.resize(0);
+
+    if (version == SEGMENT_VERSION_V1) {
+        if (h->encoding != BLOCK_RAW)
+            return;
+        const int count = int(qMin<quint32>(h->count, quint32(RAW_SAMPLES)));
+        times.resize(count);
+        values.resize(count);
+        std::memcpy(times.data(), rawTimes(h), count * sizeof(qint64));
+        std::memcpy(values.data(), rawValues(h), count * sizeof(double));
+        return;
+    }
+
+    if (h->encoding != BLOCK_GORILLA)
+        return;
+
+    times.reserve(int(h->count));
+    values.reserve(int(h->count));
+    GorillaDecoder decoder(stream(h), qMin(h->usedBits, STREAM_BITS));
+    qint64 t;
+    double v;
+    for (quint32 i = 0; i < h->count && decoder.next(t, v); i++) {
+        times.append(t);
+        values.append(v);
+    }
+}
+
+QVector<TimeSeriesSample> TimeSeriesStore::read(const QString &series,
+                                                qint64 fromMs, qint64 toMs) const
+{
+    const Series *s = seriesByName.value(seriesKey(series));
+    return s ? readSeries(s, fromMs, toMs) : QVector<TimeSeriesSample>();
+}
+
+QVector<TimeSeriesSample> TimeSeriesStore::readSeries(const Series *s,
+                                                      qint64 fromMs, qint64 toMs) const
+{
+    QVector<TimeSeriesSample> out;
+
+    for (const Segment *seg : s->segments) {
+        if (seg->usedBlocks == 0 || seg->lastMs < fromMs)
+            continue;
+        if (seg->firstMs > toMs)
+            break;
+
+        for (int b = seg->findBlock(fromMs); b <= seg->usedBlocks; b++) {
+            BlockHeader *h = seg->block(b);
+            if (h->lastMs < fromMs)
+                continue;
+            if (h->firstMs > toMs)
+                return out;
+
+            decodeBlock(seg->version, h, fromMs, toMs, out);
+        }
+    }
+    return out;
+}
+
+qint64 TimeSeriesStore::rollupWidthMs(RollupTier tier)
+{
+    switch (tier) {
+    case MinuteRollup: return 60 * 1000LL;
+    case HourRollup:   return 3600 * 1000LL;
+    case DayRollup:    return DAY_MS;
+    }
+    return DAY_MS;
+}
+
+QVector<RollupBucket> TimeSeriesStore::readRollup(const QString &series, RollupTier tier,
+                                                  qint64 fromMs, qint64 toMs) const
+{
+    const Series *s = seriesByName.value(seriesKey(series));
+    if (!s || !s->rollups[tier])
+        return QVector<RollupBucket>();
+    return s->rollups[tier]->read(fromMs, toMs);
+}
+
+// ================================================================
+//  Query
+// ================================================================
+
+QueryResult TimeSeriesStore::query(const QString &series, qint64 fromMs, qint64 toMs,
+                                   qint64 bucketMs, QueryAggregate aggregate) const
+{
+    QueryResult result;
+    result.series    = seriesKey(series);
+    result.bucketMs  = bucketMs;
+    result.aggregate = aggregate;
+
+    const Series *s = seriesByName.value(result.series);
+    if (!s || !s->hasSamples || bucketMs <= 0 || toMs < fromMs)
+        return result;
+
+    QueryBuilder out(result);
+    result.fromMs = out.bucketStart(fromMs);
+    result.toMs   = out.bucketEnd(toMs);
+    fromMs = result.fromMs;
+    toMs   = result.toMs;
+
+    // Coarsest rollup tier whose buckets tile ours and that still
+    // holds the start of the range
+    static const char *const tierNames[ROLLUP_TIERS] = { "minute", "hour", "day" };
+    for (int t = ROLLUP_TIERS - 1; t >= 0; t--) {
+        const RollupRing *ring = s->rollups[t];
+        if (!ring || bucketMs % ring->widthMs() != 0
+            || fromMs < s->lastMs - ring->retentionMs() + ring->widthMs())
+            continue;
+
+        result.source = tierNames[t];
+        for (const RollupBucket &b : ring->read(fromMs, toMs))
+            out.at(b.startMs).addSummary(b.count, b.minValue, b.maxValue, b.sum, b.last);
+        out.finish();
+        return result;
+    }
+
+    // Raw blocks. Headers carry no last value, so 'last' always decodes.
+    result.source = "raw";
+    const bool summaries = aggregate != QueryAggregate::Last;
+    QVector<qint64> times;
+    QVector<double> values;
+
+    for (const Segment *seg : s->segments) {
+        if (seg->usedBlocks == 0 || seg->lastMs < fromMs)
+            continue;
+        if (seg->firstMs > toMs)
+            break;
+
+        for (int b = seg->findBlock(fromMs); b <= seg->usedBlocks; b++) {
+            const BlockHeader *h = seg->block(b);
+            if (h->lastMs < fromMs)
+                continue;
+            if (h->firstMs > toMs)
+                break;
+
+            if (summaries && seg->version != SEGMENT_VERSION_V1 && h->encoding == BLOCK_GORILLA
+                && out.bucketStart(h->firstMs) == out.bucketStart(h->lastMs)) {
+                out.at(h->firstMs).addSummary(h->count, h->minValue, h->maxValue, h->sum);
+                continue;
+            }
+
+            decodeColumns(seg->version, h, times, values);
+            const qint64 *ts = times.constData();
+            int i         = int(std::lower_bound(ts, ts + times.size(), fromMs) - ts);
+            const int end = int(std::upper_bound(ts, ts + times.size(), toMs) - ts);
+
+            // One run per bucket the block spans
+            while (i < end) {
+                const int j = int(std::upper_bound(ts + i, ts + end, out.bucketEnd(ts[i])) - ts);
+                out.at(ts[i]).addRun(values.constData() + i, j - i);
+                i = j;
+            }
+        }
+    }
+
+    out.finish();
+    return result;
+}
@@ -0,0 +1,130 @@
+/////////////////////////////////////////////////////////////
+// TIMESERIESSTORE.H - On-Device Time-Series Store Header
+/////////////////////////////////////////////////////////////
+
+#ifndef TIMESERIESSTORE_H
+#define TIMESERIESSTORE_H
+
+#include <QObject>
+#include <QFile>
+#include <QHash>
+#include <QStringList>
+#include <QTimer>
+#include <QVector>
+
+#include "RollupRing.h"
+#include "SeriesQuery.h"
+
+// One stored sample
+struct TimeSeriesSample {
+    qint64 timestampMs;
+    double value;
+};
+
+// Append-only history of every series, kept on the SD card.
+//
+// Each series is a directory of segment files named after their
+// first timestamp:
+//   <root>/depth_sensor/0001717250400000.seg
+// A segment is a run of 4 KiB blocks (block 0 is the segment
+// header). A block holds a 64-byte header — sample count,
+// checksum, time range and min/max/sum of its values — followed by
+// a GorillaCodec bit stream, so a steady sensor costs a few bits
+// per sample and a scan can skip or summarise whole blocks from
+// their headers. Segments are created sparse and memory-mapped: an
+// append encodes straight into the page cache, and sync() msyncs
+// only the blocks written since the last sync (a block is one SD
+// page). Version 1 segments, with raw timestamp/value columns, are
+// still read.
+//
+// The sample count is the commit point: it is bumped after the
+// sample is written. On open, the last block of every series is
+// decoded, checked against its checksum and cut back to its last
+// sane sample if power was lost mid-write.
+//
+// Every sample is also folded into minute, hour and day rollups
+// (min/max/mean/count/last per UTC-aligned bucket), each a
+// RollupRing in the series directory with its own retention. Raw
+// segments span at most one day and are deleted whole once they
+// fall out of rawRetentionDays, so long-range views read the
+// rollups instead. Rollups behind the raw data after a crash are
+// caught up from it on open.
+class TimeSeriesStore : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit TimeSeriesStore(const QString &rootDir, QObject *parent = nullptr);
+    ~TimeSeriesStore();
+
+    // Map existing segments and recover tails. A read-only store
+    // (e.g. an export next to the running controller) maps every
+    // segment read-only, never repairs or expires anything, has no
+    // rollups and refuses appends.
+    enum OpenMode { ReadWrite, ReadOnly };
+    bool open(OpenMode mode = ReadWrite);
+
+    // Timestamps must not go backwards within a series; an older
+    // sample is rejected and false returned
+    bool append(const QString &series, qint64 timestampMs, double value);
+
+    void sync();                          // msync blocks written since last sync
+
+    QStringList seriesNames() const;
+    qint64 firstTimestamp(const QString &series) const;  // 0 if empty
+    qint64 lastTimestamp(const QString &series) const;   // 0 if empty
+
+    // Samples with fromMs <= timestamp <= toMs, oldest first
+    QVector<TimeSeriesSample> read(const QString &series,
+                                   qint64 fromMs, qint64 toMs) const;
+
+    enum RollupTier { MinuteRollup, HourRollup, DayRollup };
+    static const int ROLLUP_TIERS = 3;
+    static qint64 rollupWidthMs(RollupTier tier);
+
+    // Rollup buckets overlapping [fromMs, toMs], oldest first
+    QVector<RollupBucket> readRollup(const QString &series, RollupTier tier,
+                                     qint64 fromMs, qint64 toMs) const;
+
+    // One aggregate per bucketMs-wide bucket over [fromMs, toMs],
+    // widened to whole buckets. Served from the coarsest rollup
+    // tier that tiles the buckets and reaches back far enough,
+    // otherwise from raw blocks: a block inside one bucket is
+    // summarised from its header, the rest are decoded and folded
+    // in runs.
+    QueryResult query(const QString &series, qint64 fromMs, qint64 toMs,
+                      qint64 bucketMs, QueryAggregate aggregate) const;
+
+    int syncIntervalMs = 5000;            // Group commit window
+
+    // Retention, read by open(); a changed rollup retention
+    // re-slots the existing rings
+    int rawRetentionDays    = 90;
+    int minuteRetentionDays = 35;         // Covers a 30-day per-minute query
+    int hourRetentionDays   = 730;
+    int dayRetentionDays    = 3650;
+
+private:
+    struct Segment;
+    struct Series;
+
+    QString root;
+    bool    readOnly = false;
+    QHash<QString, Series*> seriesByName;
+    QTimer *syncTimer;
+
+    static QString seriesKey(const QString &name);
+    Series  *loadSeries(const QString &name);
+    Series  *createSeries(const QString &name);
+    Segment *openSegment(const QString &path, bool tail);
+    Segment *createSegment(Series *s, qint64 firstMs);
+    void     recoverTail(Series *s);
+    void     openRollups(Series *s);
+    void     expireSegments(Series *s, qint64 newestMs);
+    void     syncSeries(Series *s);
+    void     closeSegment(Segment *seg);
+    QVector<TimeSeriesSample> readSeries(const Series *s,
+                                         qint64 fromMs, qint64 toMs) const;
+};
+
+#endif // TIMESERIESSTORE_H
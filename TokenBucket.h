@@ -0,0 +1,59 @@
+/////////////////////////////////////////////////////////////
+// TOKENBUCKET.H - Token Bucket Rate Limiter
+/////////////////////////////////////////////////////////////
+
+#ifndef TOKENBUCKET_H
+#define TOKENBUCKET_H
+
+#include <QtGlobal>
+
+// Token bucket that refills continuously up to 'capacity' over
+// 'periodMs'. A capacity of 0 means unlimited.
+//
+// Callers can ask to keep a reserve: canSpend(n, 0.3) only passes
+// if at least 30% of the capacity is left afterwards, which lets
+// low-priority traffic back off while there is still headroom for
+// important traffic.
+class TokenBucket
+{
+public:
+    void configure(double newCapacity, qint64 periodMs)
+    {
+        capacity = newCapacity;
+        ratePerMs = periodMs > 0 ? newCapacity / periodMs : 0;
+        tokens = newCapacity;
+        lastRefillMs = 0;
+    }
+
+    bool unlimited() const { return capacity <= 0; }
+    double available() const { return tokens; }
+
+    bool canSpend(double amount, double reserveFraction, qint64 nowMs)
+    {
+        if (unlimited())
+            return true;
+        refill(nowMs);
+        return tokens - amount >= reserveFraction * capacity;
+    }
+
+    void spend(double amount)
+    {
+        if (!unlimited())
+            tokens -= amount;
+    }
+
+private:
+    double capacity  = 0;
+    double ratePerMs = 0;
+    double tokens    = 0;
+    qint64 lastRefillMs = 0;
+
+    void refill(qint64 nowMs)
+    {
+        if (lastRefillMs > 0)
+            tokens = qMin(capacity, tokens + (nowMs - lastRefillMs) * ratePerMs);
+        lastRefillMs = nowMs;
+    }
+};
+
+#endif // TOKENBUCKET_H
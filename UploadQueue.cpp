@@ -0,0 +1,280 @@
+/////////////////////////////////////////////////////////////
+// UPLOADQUEUE.CPP - Durable Upload Queue Implementation
+/////////////////////////////////////////////////////////////
+
+#include "UploadQueue.h"
+#include <QDataStream>
+#include <QDebug>
+#include <QDir>
+#include <QFileInfo>
+#include <QUuid>
+#include <QtEndian>
+#include <cstdio>
+#ifdef Q_OS_UNIX
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+// Record layout on disk:
+//   quint32 payload length | quint16 checksum | payload
+// A record with a bad length or checksum marks a torn tail
+// (power lost mid-write) and everything from there is dropped.
+static const int RECORD_HEADER_SIZE = 6;
+static const quint8 READING_RECORD_V1 = 1;   // Before upload priorities
+static const quint8 ACK_RECORD = 2;
+static const quint8 READING_RECORD = 3;
+static const quint32 MAX_RECORD_SIZE = 64 * 1024;
+
+// fsync a file descriptor (no-op off Unix)
+static void fsyncHandle(int fd)
+{
+#ifdef Q_OS_UNIX
+    if (fd >= 0)
+        ::fsync(fd);
+#else
+    Q_UNUSED(fd);
+#endif
+}
+
+// fsync a directory so a create/rename inside it is durable
+static void fsyncDirectory(const QString &dirPath)
+{
+#ifdef Q_OS_UNIX
+    int fd = ::open(QFile::encodeName(dirPath).constData(), O_RDONLY);
+    if (fd >= 0) {
+        ::fsync(fd);
+        ::close(fd);
+    }
+#else
+    Q_UNUSED(dirPath);
+#endif
+}
+
+static QByteArray frameRecord(const QByteArray &payload)
+{
+    QByteArray record(RECORD_HEADER_SIZE, Qt::Uninitialized);
+    qToLittleEndian<quint32>(payload.size(), record.data());
+    qToLittleEndian<quint16>(qChecksum(payload.constData(), payload.size()),
+                             record.data() + 4);
+    record.append(payload);
+    return record;
+}
+
+static QByteArray encodeReading(const SensorReading &r)
+{
+    QByteArray payload;
+    QDataStream out(&payload, QIODevice::WriteOnly);
+    out << READING_RECORD << r.seq << r.key << r.sensorId << r.unit
+        << r.timestampMs << r.value << quint8(r.priority);
+    return payload;
+}
+
+UploadQueue::UploadQueue(const QString &path, QObject *parent)
+    : QObject(parent)
+    , path(path)
+    , file(path)
+{
+    // Keys are "<per-run uuid>-<seq>": unique even if seq restarts
+    // after the log is compacted, and cheap to encode in batches
+    keyPrefix = QUuid::createUuid().toByteArray(QUuid::Id128);
+
+    syncTimer = new QTimer(this);
+    syncTimer->setSingleShot(true);
+    connect(syncTimer, &QTimer::timeout, this, &UploadQueue::sync);
+}
+
+UploadQueue::~UploadQueue()
+{
+    sync();
+}
+
+// ================================================================
+//  Startup
+// ================================================================
+
+bool UploadQueue::open()
+{
+    QDir().mkpath(QFileInfo(path).absolutePath());
+
+    if (!replay())
+        return false;
+
+    if (!file.open(QIODevice::ReadWrite | QIODevice::Append)) {
+        qWarning() << "UploadQueue: cannot open" << path << file.errorString();
+        return false;
+    }
+    fsyncDirectory(QFileInfo(path).absolutePath());
+
+    if (!pendingReadings.isEmpty())
+        qDebug() << "UploadQueue:" << pendingReadings.size()
+                 << "readings pending from previous run";
+    return true;
+}
+
+// Rebuild the pending set from the log and cut off a torn tail
+bool UploadQueue::replay()
+{
+    QFile in(path);
+    if (!in.exists())
+        return true;
+    if (!in.open(QIODevice::ReadWrite)) {
+        qWarning() << "UploadQueue: cannot read" << path << in.errorString();
+        return false;
+    }
+
+    const QByteArray log = in.readAll();
+    qint64 offset = 0;
+
+    while (offset + RECORD_HEADER_SIZE <= log.size()) {
+        const char *head = log.constData() + offset;
+        quint32 len = qFromLittleEndian<quint32>(head);
+        quint16 sum = qFromLittleEndian<quint16>(head + 4);
+
+        if (len == 0 || len > MAX_RECORD_SIZE
+            || offset + RECORD_HEADER_SIZE + len > log.size())
+            break;
+
+        const char *body = head + RECORD_HEADER_SIZE;
+        if (qChecksum(body, len) != sum)
+            break;
+
+        QDataStream ds(QByteArray::fromRawData(body, len));
+        quint8 type;
+        quint64 seq;
+        ds >> type >> seq;
+
+        if (type == READING_RECORD || type == READING_RECORD_V1) {
+            SensorReading r;
+            r.seq = seq;
+            ds >> r.key >> r.sensorId >> r.unit >> r.timestampMs >> r.value;
+            if (type == READING_RECORD) {
+                quint8 priority;
+                ds >> priority;
+                r.priority = static_cast<UploadPriority>(
+                    qMin<int>(priority, UPLOAD_PRIORITY_COUNT - 1));
+            }
+            pendingReadings.insert(seq, r);
+        } else if (type == ACK_RECORD) {
+            pendingReadings.remove(seq);
+        }
+
+        nextSeq = qMax(nextSeq, seq + 1);
+        recordsInLog++;
+        offset += RECORD_HEADER_SIZE + len;
+    }
+
+    if (offset < log.size()) {
+        qWarning() << "UploadQueue: dropping" << (log.size() - offset)
+                   << "bytes of torn tail in" << path;
+        in.resize(offset);
+        fsyncHandle(in.handle());
+    }
+    in.close();
+    return true;
+}
+
+// ================================================================
+//  Append / Ack
+// ================================================================
+
+void UploadQueue::append(SensorReading &reading)
+{
+    reading.seq = nextSeq++;
+    if (reading.key.isEmpty())
+        reading.key = keyPrefix + '-' + QByteArray::number(reading.seq);
+
+    writeRecord(encodeReading(reading));
+    pendingReadings.insert(reading.seq, reading);
+
+    // Group commit: sync on count, otherwise within syncIntervalMs
+    if (++unsynced >= syncEveryRecords)
+        sync();
+    else if (!syncTimer->isActive())
+        syncTimer->start(syncIntervalMs);
+}
+
+void UploadQueue::ack(quint64 seq)
+{
+    if (pendingReadings.remove(seq) == 0)
+        return;
+
+    QByteArray payload;
+    QDataStream out(&payload, QIODevice::WriteOnly);
+    out << ACK_RECORD << seq;
+    writeRecord(payload);
+
+    // Acks ride along with the next group commit
+    if (!syncTimer->isActive())
+        syncTimer->start(syncIntervalMs);
+
+    if (recordsInLog >= COMPACT_MIN_RECORDS
+        && pendingReadings.size() < recordsInLog / 4)
+        compact();
+}
+
+void UploadQueue::writeRecord(const QByteArray &payload)
+{
+    if (!file.isOpen())
+        return;
+    file.write(frameRecord(payload));
+    recordsInLog++;
+    dirty = true;
+}
+
+void UploadQueue::sync()
+{
+    syncTimer->stop();
+    if (!file.isOpen() || !dirty)
+        return;
+    file.flush();
+    fsyncHandle(file.handle());
+    unsynced = 0;
+    dirty = false;
+}
+
+QVector<SensorReading> UploadQueue::pending(int maxCount,
+                                            const QSet<quint64> &exclude) const
+{
+    QVector<SensorReading> out;
+    for (auto it = pendingReadings.constBegin();
+         it != pendingReadings.constEnd() && out.size() < maxCount; ++it) {
+        if (!exclude.contains(it.key()))
+            out.append(it.value());
+    }
+    return out;
+}
+
+// ================================================================
+//  Compaction
+// ================================================================
+
+// Rewrite the log with only the pending readings. The new log is
+// written beside the old one, fsynced and renamed over it, so a
+// power cut leaves either the old or the new log — never neither.
+void UploadQueue::compact()
+{
+    sync();
+
+    const QString tmpPath = path + ".tmp";
+    QFile tmp(tmpPath);
+    if (!tmp.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        qWarning() << "UploadQueue: compaction failed:" << tmp.errorString();
+        return;
+    }
+    for (const SensorReading &r : pendingReadings)
+        tmp.write(frameRecord(encodeReading(r)));
+    tmp.flush();
+    fsyncHandle(tmp.handle());
+    tmp.close();
+
+    file.close();
+    if (std::rename(QFile::encodeName(tmpPath).constData(),
+                    QFile::encodeName(path).constData()) != 0) {
+        qWarning() << "UploadQueue: cannot replace" << path;
+        QFile::remove(tmpPath);
+    }
+    fsyncDirectory(QFileInfo(path).absolutePath());
+
+    file.open(QIODevice::ReadWrite | QIODevice::Append);
+    recordsInLog = pendingReadings.size();
+}
@@ -0,0 +1,67 @@
+/////////////////////////////////////////////////////////////
+// UPLOADQUEUE.H - Durable Upload Queue Class Header
+/////////////////////////////////////////////////////////////
+
+#ifndef UPLOADQUEUE_H
+#define UPLOADQUEUE_H
+
+#include <QObject>
+#include <QFile>
+#include <QMap>
+#include <QSet>
+#include <QTimer>
+#include <QVector>
+
+#include "SensorReading.h"
+
+// On-disk write-ahead queue for sensor uploads.
+//
+// Every reading is appended to a log file before it is sent.
+// Successful uploads append an ack record; on startup the log
+// is replayed and anything without an ack is pending again.
+// Appends are fsynced in groups (by count or by timer), so a
+// power cut loses at most the last group. Acks are not synced
+// eagerly: a lost ack only causes a replay, which the server
+// deduplicates by idempotency key.
+class UploadQueue : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit UploadQueue(const QString &path, QObject *parent = nullptr);
+    ~UploadQueue();
+
+    bool open();                          // Replay the log from disk
+    void append(SensorReading &reading);  // Assigns seq and key
+    void ack(quint64 seq);                // Mark reading as delivered
+    void sync();                          // Flush and fsync pending writes
+
+    // Oldest pending readings, skipping any seq in 'exclude'
+    QVector<SensorReading> pending(int maxCount,
+                                   const QSet<quint64> &exclude = QSet<quint64>()) const;
+    int pendingCount() const { return pendingReadings.size(); }
+
+    // Group-commit tuning
+    int syncEveryRecords = 32;            // fsync after this many appends
+    int syncIntervalMs   = 1000;          // ...or after this long
+
+private:
+    QString path;
+    QFile   file;
+    QTimer *syncTimer;
+    QByteArray keyPrefix;                          // Idempotency key prefix
+
+    QMap<quint64, SensorReading> pendingReadings;  // Ordered oldest-first
+    quint64 nextSeq       = 1;
+    int     unsynced      = 0;     // Appends since last fsync
+    bool    dirty         = false; // Any write since last fsync
+    int     recordsInLog  = 0;
+
+    static const int COMPACT_MIN_RECORDS = 4096;
+
+    void writeRecord(const QByteArray &payload);
+    bool replay();
+    void compact();
+};
+
+#endif // UPLOADQUEUE_H
@@ -0,0 +1,89 @@
+/////////////////////////////////////////////////////////////
+// WIRECODEC.CPP - Upload Wire Format Encoders
+/////////////////////////////////////////////////////////////
+
+#include "WireCodec.h"
+#include "ReadingSerializer.h"
+#include <QCborArray>
+#include <QCborMap>
+#include <QCborValue>
+#include <QHash>
+
+QByteArray WireCodec::toJson(const SensorReading &reading)
+{
+    // One serializer per thread, so its escape cache and buffer
+    // survive between calls. The body is copied out because the
+    // network stack keeps it alive until the request completes.
+    static thread_local ReadingSerializer serializer(1024);
+    serializer.clear();
+    serializer.appendJson(reading);
+    const QByteArray &json = serializer.bytes();
+    return QByteArray(json.constData(), json.size());
+}
+
+QByteArray WireCodec::toCbor(const QVector<SensorReading> &readings)
+{
+    QCborArray sensors, units, keys, rows;
+    QHash<QString, int>    sensorIndex;
+    QHash<QByteArray, int> keyIndex;
+
+    qint64 t0 = readings.isEmpty() ? 0 : readings.first().timestampMs;
+    qint64 prevTime = t0;
+    qint64 prevN    = 0;
+
+    for (const SensorReading &r : readings) {
+        // Dictionary-code the sensor id (and its unit)
+        auto sit = sensorIndex.constFind(r.sensorId);
+        int sid;
+        if (sit == sensorIndex.constEnd()) {
+            sid = sensors.size();
+            sensorIndex.insert(r.sensorId, sid);
+            sensors.append(r.sensorId);
+            units.append(r.unit);
+        } else {
+            sid = sit.value();
+        }
+
+        // Split "<prefix>-<n>" keys so consecutive readings from the
+        // same queue cost one byte of key each
+        int dash = r.key.lastIndexOf('-');
+        QByteArray prefix = dash < 0 ? r.key : r.key.left(dash);
+        qint64     n      = dash < 0 ? 0 : r.key.mid(dash + 1).toLongLong();
+
+        auto kit = keyIndex.constFind(prefix);
+        int kid;
+        if (kit == keyIndex.constEnd()) {
+            kid = keys.size();
+            keyIndex.insert(prefix, kid);
+            keys.append(QByteArray::fromHex(prefix));
+        } else {
+            kid = kit.value();
+        }
+
+        rows.append(sid);
+        rows.append(r.timestampMs - prevTime);
+        rows.append(qRound64(r.value * 100.0));
+        rows.append(kid);
+        rows.append(n - prevN);
+
+        prevTime = r.timestampMs;
+        prevN    = n;
+    }
+
+    QCborMap batch;
+    batch[QStringLiteral("v")]       = 1;
+    batch[QStringLiteral("sensors")] = sensors;
+    batch[QStringLiteral("units")]   = units;
+    batch[QStringLiteral("keys")]    = keys;
+    batch[QStringLiteral("t0")]      = t0;
+    batch[QStringLiteral("rows")]    = rows;
+
+    return QCborValue(batch).toCbor();
+}
+
+QByteArray WireCodec::deflate(const QByteArray &data)
+{
+    // qCompress prepends a 4-byte length; what follows is a plain
+    // zlib stream
+    return qCompress(data, 9).mid(4);
+}
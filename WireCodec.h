@@ -0,0 +1,45 @@
+/////////////////////////////////////////////////////////////
+// WIRECODEC.H - Upload Wire Format Encoders
+/////////////////////////////////////////////////////////////
+
+#ifndef WIRECODEC_H
+#define WIRECODEC_H
+
+#include <QByteArray>
+#include <QVector>
+
+#include "SensorReading.h"
+
+// Encoders for the bodies POSTed by DatabaseWriter.
+//
+// JSON (application/json) is the original one-reading-per-request
+// format and stays the fallback for servers that don't speak CBOR.
+//
+// CBOR (application/cbor) packs a batch of readings into one map:
+//   {
+//     "v":       1,
+//     "sensors": ["depth_sensor", ...],   // dictionary of sensor ids
+//     "units":   ["cm", ...],             // unit per dictionary entry
+//     "keys":    [h'..', ...],            // idempotency key prefixes
+//     "t0":      first timestamp (ms since epoch),
+//     "rows":    [sid, dt, v, kid, dn,  sid, dt, v, kid, dn, ...]
+//   }
+// Each reading is five integers in "rows":
+//   sid  index into "sensors"/"units"
+//   dt   ms since the previous reading's timestamp (t0 for the first)
+//   v    value in hundredths (the JSON format's 2-decimal precision)
+//   kid  index into "keys"
+//   dn   key sequence delta from the previous reading (starts at 0);
+//        key = hex(keys[kid]) + "-" + n, or just hex(keys[kid]) if n == 0
+// The body is then deflated and sent with Content-Encoding: deflate.
+class WireCodec
+{
+public:
+    static QByteArray toJson(const SensorReading &reading);
+    static QByteArray toCbor(const QVector<SensorReading> &readings);
+
+    // zlib-wrapped deflate stream, as HTTP "deflate" expects
+    static QByteArray deflate(const QByteArray &data);
+};
+
+#endif // WIRECODEC_H
@@ -3,165 +3,776 @@
 /////////////////////////////////////////////////////////////
 
 #include "chartcontainer.h"
+#include <QBuffer>
+#include <QCoreApplication>
+#include <QDebug>
+#include <QEvent>
+#include <QFileInfo>
+#include <QPointer>
+#include <QSaveFile>
+#include <QSvgGenerator>
+#include <QThread>
+#include <QTimer>
+#include <QWheelEvent>
+#include <cmath>
+#include <functional>
+#include <memory>
 
 #if QT_VERSION < QT_VERSION_CHECK(6, 0, 0)
 using namespace QtCharts;
 #endif
 
+// Passes on the view being shown or resized, its window being
+// restored from minimized, and mouse input on its viewport (which
+// a handler may consume); parented to the view
+class ViewWatcher : public QObject
+{
+public:
+    ViewWatcher(QWidget* view, QWidget* input, std::function<void()> onShown,
+                std::function<void()> onResized, std::function<bool(QEvent*)> onInput)
+        : QObject(view), view(view), input(input)
+        , onShown(onShown), onResized(onResized), onInput(onInput)
+    {
+        view->installEventFilter(this);
+        input->installEventFilter(this);
+    }
+
+protected:
+    bool eventFilter(QObject* watched, QEvent* event) override
+    {
+        if (watched == input) {
+            return onInput(event);
+        } else if (watched == view && event->type() == QEvent::Resize) {
+            onResized();
+        } else if (watched == view && event->type() == QEvent::Show) {
+            // The view is only in its final window once it is shown
+            QWidget* top = view->window();
+            if (top != window && top != view) {
+                if (window)
+                    window->removeEventFilter(this);
+                window = top;
+                window->installEventFilter(this);
+            }
+            onShown();
+        } else if (watched == window && event->type() == QEvent::WindowStateChange) {
+            onShown();
+        }
+        return false;
+    }
+
+private:
+    QWidget* view;
+    QWidget* input;
+    QPointer<QWidget> window;
+    std::function<void()> onShown;
+    std::function<void()> onResized;
+    std::function<bool(QEvent*)> onInput;
+};
+
+// Charts changed during the current event-loop turn
+static QVector<ChartContainer*> renderQueue;
+
+// One line's work for the preparation thread, and its result
+struct ChartContainer::PrepJob {
+    QString key;                       // Multi layout trace; empty for Single
+    quint64 generation = 0;            // Trace::generation when posted
+    int     width      = 0;
+    QVector<WeatherData> source;       // Convert into 'points' if not empty
+    QVector<QPointF> points;           // Full resolution
+    QVector<QPointF> shown;            // LTTB output when reduced
+    bool    reduced = false;
+    double  minY    = 0;
+    double  maxY    = 0;
+    bool    buildPyramid = false;      // Zoom enabled: index 'points' too
+    MinMaxPyramid pyramid;
+};
+
+// Point buffers go back here once QtCharts lets go of them, so
+// steady redraws reuse the same memory. GUI thread only.
+static QVector<QVector<QPointF>> bufferPool;
+static const int BUFFER_POOL_MAX = 16;
+
+static QVector<QPointF> takeBuffer()
+{
+    QVector<QPointF> buffer;
+    if (!bufferPool.isEmpty()) {
+        buffer.swap(bufferPool.last());
+        bufferPool.removeLast();
+    }
+    return buffer;
+}
+
+// Only a buffer nothing else shares is kept; resize(0) keeps its
+// capacity
+static void recycleBuffer(QVector<QPointF>& buffer)
+{
+    if (buffer.capacity() > 0 && buffer.isDetached() && bufferPool.size() < BUFFER_POOL_MAX) {
+        buffer.resize(0);
+        bufferPool.append(QVector<QPointF>());
+        bufferPool.last().swap(buffer);
+    }
+    buffer = QVector<QPointF>();
+}
+
+// The thread every chart prepares on, started on first use and
+// stopped as the application quits
+static QObject* preparationContext()
+{
+    static QThread* thread  = nullptr;
+    static QObject* context = nullptr;
+    if (!context) {
+        thread = new QThread();
+        thread->setObjectName("chart-prepare");
+        context = new QObject();
+        context->moveToThread(thread);
+        QObject::connect(thread, &QThread::finished, context, &QObject::deleteLater);
+        QObject::connect(qApp, &QCoreApplication::aboutToQuit, []() {
+            thread->quit();
+            thread->wait();
+        });
+        thread->start(QThread::LowPriority);
+    }
+    return context;
+}
+
 // Constructor: Initialize with 10 random colors for chart series
 ChartContainer::ChartContainer()
 {
     for (int i = 0; i < 10; i++)
         colors.append(QColor(rand() % 256, rand() % 256, rand() % 256));
+
+    // The view keeps this chart for its whole life; only its
+    // series and axes change
+    chartview->setChart(chart);
+    chartview->setRenderHint(QPainter::Antialiasing);
+
+    new ViewWatcher(chartview, chartview->viewport(),
+                    [this]() { onViewShown(); },
+                    [this]() { onViewResized(); },
+                    [this](QEvent* event) { return onViewInput(event); });
 }
 
+// ================================================================
+//  Data
+// ================================================================
+
 // Plot a single weather data series on the chart
 void ChartContainer::plotWeatherData(const QVector<WeatherData>& weatherData, const QString& yAxisTitle) {
-    // Clear existing series and axes from the chart
-    chart->removeAllSeries();
-    removeAllAxes();
+    useLayout(Layout::Single);
+    singleTitle = yAxisTitle;
+    single.color = colors[0];
+    setSource(single, weatherData);        // Shared, not copied
+    requestRender();
+}
+
+// Plot a contiguous run of points (e.g. a RingHistory window); the
+// run is copied since the caller's buffer keeps moving
+void ChartContainer::plotWeatherData(const WeatherData* points, int count, const QString& yAxisTitle) {
+    QVector<WeatherData> copy;
+    copy.reserve(count);
+    for (const WeatherData* data = points; data != points + count; ++data)
+        copy.append(*data);
+    plotWeatherData(copy, yAxisTitle);
+}
 
-    // Create a new line series for the data
-    QLineSeries* series = new QLineSeries();
-    double max_val = -1e6;
+void ChartContainer::appendPoint(const WeatherData& point, qint64 keepMs, const QString& yAxisTitle) {
+    if (layout != Layout::Single) {
+        plotWeatherData(&point, 1, yAxisTitle);
+        return;
+    }
+    singleTitle = yAxisTitle;
+    single.generation = ++generations;
+    const qint64 cutoffMs = point.timestamp.toMSecsSinceEpoch() - keepMs;
 
-    // Add all data points to the series and track maximum value
-    for (const auto& data : weatherData) {
-        series->append(data.timestamp.toMSecsSinceEpoch(), data.value);
-        max_val = std::max(data.value, max_val);
+    // Not converted yet: extend the data the pending job will convert
+    if (!single.converted) {
+        QVector<WeatherData>& source = single.source;
+        source.append(point);
+        int excess = 0;
+        while (excess < source.size() - 1
+               && source[excess].timestamp.toMSecsSinceEpoch() < cutoffMs)
+            excess++;
+        source.remove(0, excess);
+        single.replot = true;
+        requestRender();
+        return;
     }
 
-    // Customize the line appearance (width and color)
-    QPen pen = series->pen();
-    pen.setWidth(4); // Set the desired line thickness
-    pen.setColor(colors[0]);
-    series->setPen(pen);
-
-    // Add the series to the chart and configure it
-    chart->addSeries(series);
-    chart->setTitle(yAxisTitle);
-    chart->setAnimationOptions(animated ? QChart::SeriesAnimations : QChart::NoAnimation);
-
-    // Configure X-axis (time axis)
-    QDateTimeAxis* axisX = new QDateTimeAxis();
-    axisX->setTitleText("Time");
-    axisX->setFormat("dd/MM HH:mm");
-    QFont xAxisFont = axisX->labelsFont();
-    xAxisFont.setPointSize(8); // Make font smaller
-    axisX->setLabelsFont(xAxisFont);
-    axisX->setTickCount(20);
-    axisX->setLabelsAngle(90.0); // Rotate labels by 90 degrees
-    chart->addAxis(axisX, Qt::AlignBottom);
-    series->attachAxis(axisX);
+    QVector<QPointF>& line = single.points;
+    line.append(QPointF(point.timestamp.toMSecsSinceEpoch(), point.value));
+    single.maxY = line.size() == 1 ? point.value : std::max(point.value, single.maxY);
+    single.appended++;
+    single.pyramidStale = true;
 
-    // Configure Y-axis (value axis)
-    QValueAxis* axisY = new QValueAxis();
-    axisY->setTitleText(yAxisTitle);
-    axisY->setLabelFormat("%.1f");
-    QFont yAxisFont = axisY->labelsFont();
-    axisY->setRange(0, max_val);
-    yAxisFont.setPointSize(8); // Make font smaller
-    axisY->setLabelsFont(yAxisFont);
-    chart->addAxis(axisY, Qt::AlignLeft);
-    series->attachAxis(axisY);
+    // Slide the window; rescan for the maximum only if it just left
+    int excess = 0;
+    while (excess < line.size() - 1 && line[excess].x() < cutoffMs)
+        excess++;
+    if (excess > 0) {
+        bool maxDropped = false;
+        for (int i = 0; i < excess; i++)
+            maxDropped = maxDropped || line[i].y() >= single.maxY;
+        line.remove(0, excess);
+        single.dropped += excess;
 
-    // Update the chart view with anti-aliasing for smooth rendering
-    chartview->setChart(chart);
-    chartview->setRenderHint(QPainter::Antialiasing);
+        if (maxDropped) {
+            single.maxY = -1e6;
+            for (const QPointF& p : line)
+                single.maxY = std::max(p.y(), single.maxY);
+        }
+    }
+    requestRender();
 }
 
 // Plot multiple weather data series on the same chart (multi-line chart)
 void ChartContainer::plotWeatherDataMap(const QMap<QString, QVector<WeatherData>>& weatherDataMap) {
-    // Clear existing series and axes
-    chart->removeAllSeries();
-    removeAllAxes();
-    chart->setAnimationOptions(animated ? QChart::SeriesAnimations : QChart::NoAnimation);
+    useLayout(Layout::Multi);
 
-    // Find the time range across all series for a unified X-axis
-    QDateTime minTime = QDateTime::currentDateTime();
-    QDateTime maxTime = QDateTime::fromSecsSinceEpoch(0);
+    // Drop lines whose data type is no longer in the map
+    for (auto it = traces.begin(); it != traces.end(); ) {
+        if (weatherDataMap.contains(it.key())) {
+            ++it;
+        } else {
+            removeTrace(it.value());
+            it = traces.erase(it);
+        }
+    }
+
+    // Time range across all series for a unified X-axis
+    multiFromMs = QDateTime::currentMSecsSinceEpoch();
+    multiToMs   = 0;
 
+    int counter = 0;
     for (auto it = weatherDataMap.begin(); it != weatherDataMap.end(); ++it) {
+        counter++;
         const QVector<WeatherData>& weatherData = it.value();
+
+        Trace& trace = traces[it.key()];
+        trace.color = colors[counter];
+        setSource(trace, weatherData);
+
         if (!weatherData.empty()) {
-            QDateTime seriesStartTime = weatherData.front().timestamp;
-            QDateTime seriesEndTime = weatherData.back().timestamp;
+            multiFromMs = std::min(multiFromMs, weatherData.front().timestamp.toMSecsSinceEpoch());
+            multiToMs   = std::max(multiToMs, weatherData.back().timestamp.toMSecsSinceEpoch());
+        }
+    }
+    requestRender();
+}
 
-            if (seriesStartTime < minTime) {
-                minTime = seriesStartTime;
-            }
-            if (seriesEndTime > maxTime) {
-                maxTime = seriesEndTime;
+// New data for a line, converted to points on the next render
+void ChartContainer::setSource(Trace& trace, QVector<WeatherData> data) {
+    trace.source     = data;
+    trace.converted  = false;
+    trace.generation = ++generations;
+    trace.replot     = true;
+    trace.pyramidStale = true;
+    recycleBuffer(trace.points);
+}
+
+// Switching between one line and several deletes what the old
+// layout built
+void ChartContainer::useLayout(Layout wanted) {
+    if (layout == wanted)
+        return;
+
+    removeTrace(single);
+    single = Trace();
+    for (Trace& trace : traces)
+        removeTrace(trace);
+    traces.clear();
+    layout = wanted;
+}
+
+// ================================================================
+//  Rendering
+// ================================================================
+
+// Queue for the next event-loop turn; all charts queued in one turn
+// render together
+void ChartContainer::requestRender() {
+    dirty = true;
+    if (queued)
+        return;
+
+    queued = true;
+    if (renderQueue.isEmpty())
+        QTimer::singleShot(0, &ChartContainer::renderQueued);
+    renderQueue.append(this);
+}
+
+void ChartContainer::renderQueued() {
+    const QVector<ChartContainer*> batch = renderQueue;
+    renderQueue.clear();
+    for (ChartContainer* container : batch) {
+        container->queued = false;
+        container->render();
+    }
+}
+
+bool ChartContainer::isShown() const {
+    return chartview->isVisible() && !chartview->window()->isMinimized();
+}
+
+// Push the recorded data into QtCharts. A hidden chart stays dirty
+// and renders when onViewShown() sees it again, unless 'now' asks
+// for a complete chart at once (for an image)
+void ChartContainer::render(bool now) {
+    if (!now && (!dirty || !isShown()))
+        return;
+    dirty = false;
+
+    if (!axisX) {
+        axisX = new QDateTimeAxis();
+        axisX->setTitleText("Time");
+        axisX->setFormat("dd/MM HH:mm");
+        QFont xAxisFont = axisX->labelsFont();
+        xAxisFont.setPointSize(8); // Make font smaller
+        axisX->setLabelsFont(xAxisFont);
+        axisX->setLabelsAngle(90.0); // Rotate labels by 90 degrees
+        chart->addAxis(axisX, Qt::AlignBottom);
+    }
+    // An image must not catch a line halfway through its animation
+    chart->setAnimationOptions(animated && !now ? QChart::SeriesAnimations : QChart::NoAnimation);
+
+    if (layout == Layout::Single) {
+        axisX->setTickCount(20);
+        if (!single.series)
+            buildTrace(single, singleTitle);
+        chart->setTitle(singleTitle);
+        single.axisY->setTitleText(singleTitle);
+        update(single, QString(), now);
+    } else if (layout == Layout::Multi) {
+        axisX->setTickCount(10);
+
+        // Customize chart title font
+        QFont titleFont = chart->titleFont();
+        titleFont.setPointSize(10); // Make font smaller
+        chart->setTitleFont(titleFont);
+
+        for (auto it = traces.begin(); it != traces.end(); ++it) {
+            Trace& trace = it.value();
+            if (!trace.series) {
+                buildTrace(trace, it.key());
+                trace.series->setName(it.key());
             }
+            update(trace, it.key(), now);
         }
+        applyTimeRange();
     }
+}
 
-    // Create and configure the shared X-axis (time)
-    QDateTimeAxis* axisX = new QDateTimeAxis();
-    axisX->setTitleText("Time");
-    axisX->setFormat("dd/MM HH:mm");
-    axisX->setTickCount(10);
-    QFont xAxisFont = axisX->labelsFont();
-    xAxisFont.setPointSize(8); // Make font smaller
-    axisX->setLabelsFont(xAxisFont);
-    axisX->setLabelsAngle(90.0); // Rotate labels by 90 degrees
-    axisX->setRange(minTime, maxTime);
-    chart->addAxis(axisX, Qt::AlignBottom);
+// A line on the shared X-axis with a Y-axis of its own
+void ChartContainer::buildTrace(Trace& trace, const QString& yAxisTitle) {
+    trace.series = new QLineSeries();
 
-    // Create a separate series and Y-axis for each data type in the map
-    int counter = 0;
-    for (auto it = weatherDataMap.begin(); it != weatherDataMap.end(); ++it) {
-        counter++;
-        const QString& yAxisTitle = it.key();
-        const QVector<WeatherData>& weatherData = it.value();
+    // Customize the line appearance (width and color)
+    QPen pen = trace.series->pen();
+    pen.setWidth(4); // Set the desired line thickness
+    pen.setColor(trace.color);
+    trace.series->setPen(pen);
+
+    chart->addSeries(trace.series);
+    trace.series->attachAxis(axisX);
+
+    // Configure Y-axis (value axis)
+    trace.axisY = new QValueAxis();
+    trace.axisY->setTitleText(yAxisTitle);
+    trace.axisY->setLabelFormat("%.1f");
+    QFont yAxisFont = trace.axisY->labelsFont();
+    yAxisFont.setPointSize(8); // Make font smaller
+    trace.axisY->setLabelsFont(yAxisFont);
+    chart->addAxis(trace.axisY, Qt::AlignLeft);
+    trace.series->attachAxis(trace.axisY);
+
+    trace.replot = true;
+}
+
+// removeSeries()/removeAxis() hand ownership back, so delete both
+void ChartContainer::removeTrace(Trace& trace) {
+    if (!trace.series)
+        return;
+    chart->removeSeries(trace.series);
+    delete trace.series;
+    chart->removeAxis(trace.axisY);
+    delete trace.axisY;
+    trace.series = nullptr;
+    trace.axisY  = nullptr;
+}
+
+void ChartContainer::update(Trace& trace, const QString& key, bool now) {
+    // finishPrepare() renders again if the data moved on meanwhile
+    if (trace.inFlight && !now)
+        return;
+
+    // A stale pyramid is rebuilt on the preparation thread, and
+    // finishPrepare() shows the envelope
+    if (zoomed() && trace.converted && !trace.inFlight) {
+        if (trace.pyramidStale)
+            prepare(trace, key, now);
+        else
+            showEnvelope(trace);
+        return;
+    }
+
+    const int count = trace.points.size();
+
+    // While the line fits the view the series mirrors it point for
+    // point, so appends and drops are passed on as they are
+    if (!trace.inFlight && trace.converted && !trace.replot && !trace.reduced && count <= plotWidth()
+        && trace.appended <= count && trace.dropped <= trace.series->count()) {
+        if (trace.dropped > 0)
+            trace.series->removePoints(0, trace.dropped);
+        for (int i = count - trace.appended; i < count; i++)
+            trace.series->append(trace.points[i]);
+        trace.appended = 0;
+        trace.dropped  = 0;
+        setRanges(trace);
+    } else {
+        prepare(trace, key, now);
+    }
+}
+
+void ChartContainer::setRanges(Trace& trace) {
+    if (trace.points.isEmpty())
+        return;
+
+    if (layout == Layout::Single) {
+        applyTimeRange();
+        trace.axisY->setRange(0, trace.maxY);
+    } else {
+        trace.axisY->setRange(trace.minY, trace.maxY > trace.minY ? trace.maxY : trace.minY + 1);
+    }
+}
+
+// ================================================================
+//  Background Preparation
+// ================================================================
+
+// Hand the line's data to the preparation thread, or with 'now'
+// prepare it right here
+void ChartContainer::prepare(Trace& trace, const QString& key, bool now) {
+    std::shared_ptr<PrepJob> job = std::make_shared<PrepJob>();
+    job->key        = key;
+    job->generation = trace.generation;
+    job->width      = plotWidth();
+    job->buildPyramid = zoomEnabled;
+    if (trace.converted) {
+        job->points = trace.points;        // Shared snapshot
+    } else {
+        job->source = trace.source;
+        job->points = takeBuffer();
+    }
+    job->shown = takeBuffer();
+
+    trace.inFlight = true;
+    trace.replot   = false;
+    trace.appended = 0;
+    trace.dropped  = 0;
 
-        // Create a line series for this data type
-        QLineSeries* series = new QLineSeries();
-        series->setName(yAxisTitle);
+    if (now) {
+        runPrepJob(*job);
+        finishPrepare(*job);
+        return;
+    }
+
+    QMetaObject::invokeMethod(preparationContext(), [this, job]() {
+        runPrepJob(*job);
+
+        // The view as context: dropped if it is gone by then
+        QMetaObject::invokeMethod(chartview, [this, job]() { finishPrepare(*job); },
+                                  Qt::QueuedConnection);
+    }, Qt::QueuedConnection);
+}
+
+// Conversion to points if still pending, the min/max scan and
+// LTTB. Touches nothing but the job
+void ChartContainer::runPrepJob(PrepJob& job) {
+    if (!job.source.isEmpty()) {
+        job.points.reserve(job.source.size());
+        for (const WeatherData& data : job.source)
+            job.points.append(QPointF(data.timestamp.toMSecsSinceEpoch(), data.value));
+        job.source = QVector<WeatherData>();
+    }
+
+    // Read-only: points may be shared with the trace
+    const QPointF* points = job.points.constData();
+    for (int i = 0; i < job.points.size(); i++) {
+        const double y = points[i].y();
+        job.minY = i == 0 ? y : std::min(y, job.minY);
+        job.maxY = i == 0 ? y : std::max(y, job.maxY);
+    }
+
+    job.reduced = job.points.size() > job.width;
+    if (job.reduced)
+        Downsampler::lttb(job.points.constData(), job.points.size(), job.width, job.shown);
+    if (job.buildPyramid)
+        job.pyramid.build(job.points.constData(), job.points.size());
+}
 
-        // Add all data points to the series
-        for (const auto& data : weatherData) {
-            series->append(data.timestamp.toMSecsSinceEpoch(), data.value);
+// Swap the prepared points in, unless the line changed or went away
+// while they were being prepared; then render again from the new data
+void ChartContainer::finishPrepare(PrepJob& job) {
+    Trace* trace = nullptr;
+    if (job.key.isEmpty() && layout == Layout::Single)
+        trace = &single;
+    else if (!job.key.isEmpty() && layout == Layout::Multi && traces.contains(job.key))
+        trace = &traces[job.key];
+
+    if (!trace || !trace->series || trace->generation != job.generation) {
+        if (trace) {
+            trace->inFlight = false;
+            trace->replot   = true;
+            requestRender();
         }
+        recycleBuffer(job.points);
+        recycleBuffer(job.shown);
+        return;
+    }
 
-        // Customize line appearance with unique color
-        QPen pen = series->pen();
-        pen.setWidth(4); // Set the desired line thickness
-        pen.setColor(colors[counter]);
-        series->setPen(pen);
-
-        // Add the series to the chart and attach to X-axis
-        chart->addSeries(series);
-        series->attachAxis(axisX);
-
-        // Create a dedicated Y-axis for this series
-        QValueAxis* axisY = new QValueAxis();
-        axisY->setTitleText(yAxisTitle);
-        QFont yAxisFont = axisY->labelsFont();
-        yAxisFont.setPointSize(8); // Make font smaller
-        axisY->setLabelsFont(yAxisFont);
-        axisY->setLabelFormat("%.1f");
-        chart->addAxis(axisY, Qt::AlignLeft);
-        series->attachAxis(axisY);
-    }
-
-    // Customize chart title font
-    QFont titleFont = chart->titleFont();
-    titleFont.setPointSize(10); // Make font smaller
-    chart->setTitleFont(titleFont);
-
-    // Update chart view with anti-aliasing
-    chartview->setChart(chart);
-    chartview->setRenderHint(QPainter::Antialiasing);
+    trace->inFlight = false;
+    if (!trace->converted) {
+        recycleBuffer(trace->points);
+        trace->points    = job.points;
+        trace->source    = QVector<WeatherData>();
+        trace->converted = true;
+    }
+    trace->minY       = job.minY;
+    trace->maxY       = job.maxY;
+    trace->pyramid      = job.pyramid;
+    trace->pyramidStale = !job.buildPyramid;
+
+    if (zoomed()) {
+        recycleBuffer(job.shown);
+        showEnvelope(*trace);
+        return;
+    }
+    trace->reduced    = job.reduced;
+    trace->shownWidth = job.width;
+
+    // One replace() instead of clear + append per point: a single
+    // pointsReplaced signal and a single repaint. The series lets
+    // go of the buffer it had, which can then be reused
+    trace->series->replace(job.reduced ? job.shown : trace->points);
+    recycleBuffer(trace->shown);
+    if (job.reduced)
+        trace->shown = job.shown;
+    else
+        recycleBuffer(job.shown);
+    setRanges(*trace);
+}
+
+void ChartContainer::onViewShown() {
+    if (dirty)
+        requestRender();
 }
 
-// Helper function to remove all axes from the chart
-void ChartContainer::removeAllAxes() {
-    // Get a list of all axes associated with the chart
-    QList<QAbstractAxis*> axes = chart->axes();
+// Only lines that are, or now need to be, reduced change with width
+void ChartContainer::onViewResized() {
+    const int width = plotWidth();
+    bool changed = false;
+    auto check = [&](Trace& trace) {
+        if (trace.series && trace.shownWidth != width
+            && (trace.reduced || trace.points.size() > width)) {
+            trace.replot = true;
+            changed = true;
+        }
+    };
+
+    check(single);
+    for (Trace& trace : traces)
+        check(trace);
+    if (changed)
+        requestRender();
+}
+
+void ChartContainer::setTimeRange(qint64 fromMs, qint64 toMs) {
+    if (toMs <= fromMs)
+        toMs = fromMs + 60 * 1000;     // A lone point still gets a span
+    axisX->setRange(QDateTime::fromMSecsSinceEpoch(fromMs), QDateTime::fromMSecsSinceEpoch(toMs));
+}
+
+// ================================================================
+//  Zoom
+// ================================================================
+
+bool ChartContainer::dataRange(qint64& fromMs, qint64& toMs) const {
+    if (layout == Layout::Single && !single.points.isEmpty()) {
+        fromMs = qint64(single.points.first().x());
+        toMs   = qint64(single.points.last().x());
+        return true;
+    }
+    if (layout == Layout::Multi && multiToMs >= multiFromMs) {
+        fromMs = multiFromMs;
+        toMs   = multiToMs;
+        return true;
+    }
+    return false;
+}
+
+void ChartContainer::applyTimeRange() {
+    qint64 fromMs, toMs;
+    if (zoomed())
+        setTimeRange(viewFromMs, viewToMs);
+    else if (dataRange(fromMs, toMs))
+        setTimeRange(fromMs, toMs);
+}
+
+// Keep the window inside the data; an empty window, or one covering
+// all of it, is the unzoomed view
+void ChartContainer::setView(qint64 fromMs, qint64 toMs) {
+    qint64 dataFrom, dataTo;
+    if (toMs <= fromMs || !dataRange(dataFrom, dataTo) || toMs - fromMs >= dataTo - dataFrom) {
+        fromMs = toMs = 0;
+    } else {
+        const qint64 span = toMs - fromMs;
+        fromMs = std::max(dataFrom, std::min(fromMs, dataTo - span));
+        toMs   = fromMs + span;
+    }
+    if (fromMs == viewFromMs && toMs == viewToMs)
+        return;
+
+    viewFromMs = fromMs;
+    viewToMs   = toMs;
+    single.replot = true;
+    for (Trace& trace : traces)
+        trace.replot = true;
+    requestRender();
+}
+
+// One low/high pair per pixel across the window, from the pyramid;
+// update() has it rebuilt off this thread if the points changed,
+// so the rebuild here is only a fallback
+void ChartContainer::showEnvelope(Trace& trace) {
+    if (trace.pyramidStale) {
+        trace.pyramid.build(trace.points.constData(), trace.points.size());
+        trace.pyramidStale = false;
+    }
+
+    QVector<QPointF> buffer = takeBuffer();
+    trace.pyramid.envelope(trace.points.constData(), trace.points.size(),
+                           double(viewFromMs), double(viewToMs), plotWidth(), buffer);
+    trace.series->replace(buffer);
+    recycleBuffer(trace.shown);
+    trace.shown.swap(buffer);
+
+    trace.reduced    = true;       // Not a mirror of 'points'
+    trace.shownWidth = -1;         // Any resize redraws
+    trace.replot     = false;
+    trace.appended   = 0;
+    trace.dropped    = 0;
+    setRanges(trace);
+}
+
+bool ChartContainer::onViewInput(QEvent* event) {
+    if (!zoomEnabled || !axisX)
+        return false;
+
+    const qint64 fromMs = axisX->min().toMSecsSinceEpoch();
+    const qint64 toMs   = axisX->max().toMSecsSinceEpoch();
+    const QRectF area   = chart->plotArea();
+    if (area.width() <= 0 || toMs <= fromMs)
+        return false;
+
+    // Viewport pixel -> chart coordinates -> time
+    auto timeAt = [&](const QPoint& pos) {
+        const QPointF p = chart->mapFromScene(chartview->mapToScene(pos));
+        const double f = std::min(1.0, std::max(0.0, (p.x() - area.left()) / area.width()));
+        return fromMs + qint64(f * (toMs - fromMs));
+    };
+
+    switch (event->type()) {
+    case QEvent::Wheel: {
+        QWheelEvent* wheel = static_cast<QWheelEvent*>(event);
+        const double factor = std::pow(0.8, wheel->angleDelta().y() / 120.0);
+#if QT_VERSION >= QT_VERSION_CHECK(5, 14, 0)
+        const qint64 at   = timeAt(wheel->position().toPoint());
+#else
+        const qint64 at   = timeAt(wheel->pos());
+#endif
+        const qint64 span = std::max<qint64>(10 * 60 * 1000, qint64((toMs - fromMs) * factor));
+        const qint64 from = at - qint64(double(at - fromMs) / (toMs - fromMs) * span);
+        setView(from, from + span);
+        return true;
+    }
+    case QEvent::MouseButtonPress: {
+        QMouseEvent* mouse = static_cast<QMouseEvent*>(event);
+        if (mouse->button() != Qt::LeftButton || !zoomed())
+            return false;
+        dragX      = mouse->pos().x();
+        dragFromMs = fromMs;
+        return true;
+    }
+    case QEvent::MouseMove: {
+        if (dragX < 0)
+            return false;
+        QMouseEvent* mouse = static_cast<QMouseEvent*>(event);
+        const qint64 span  = toMs - fromMs;
+        const qint64 shift = qint64((dragX - mouse->pos().x()) / area.width() * span);
+        setView(dragFromMs + shift, dragFromMs + shift + span);
+        return true;
+    }
+    case QEvent::MouseButtonRelease:
+        if (dragX < 0)
+            return false;
+        dragX = -1;
+        return true;
+    case QEvent::MouseButtonDblClick:
+        setView(0, 0);
+        return true;
+    default:
+        return false;
+    }
+}
+
+// ================================================================
+//  Images
+// ================================================================
+
+QByteArray ChartContainer::renderImage(const QByteArray& format, const QSize& size) {
+    if (format != "png" && format != "svg")
+        return QByteArray();
+
+    // Resizing a view on screen would show; a hidden one is free to
+    // take whatever size the image needs
+    if (!isShown() && chartview->size() != size)
+        chartview->resize(size);
+    render(true);
+
+    const QSize imageSize = chartview->size();
+    QBuffer out;
+    out.open(QIODevice::WriteOnly);
+
+    if (format == "svg") {
+        QSvgGenerator svg;
+        svg.setOutputDevice(&out);
+        svg.setSize(imageSize);
+        svg.setViewBox(QRect(QPoint(0, 0), imageSize));
+        svg.setTitle(chart->title());
+        QPainter painter(&svg);
+        chartview->render(&painter);
+    } else {
+        QImage image(imageSize, QImage::Format_ARGB32_Premultiplied);
+        image.fill(Qt::white);
+        QPainter painter(&image);
+        painter.setRenderHint(QPainter::Antialiasing);
+        chartview->render(&painter);
+        painter.end();
+        image.save(&out, "PNG");
+    }
+    return out.data();
+}
+
+bool ChartContainer::saveImage(const QString& path, const QSize& size) {
+    const QByteArray image = renderImage(QFileInfo(path).suffix().toLower().toLatin1(), size);
+    if (image.isEmpty()) {
+        qWarning() << "ChartContainer: cannot render" << path;
+        return false;
+    }
 
-    // Loop through each axis and remove it
-    for (QAbstractAxis* axis : axes) {
-        chart->removeAxis(axis);
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly) || file.write(image) != image.size() || !file.commit()) {
+        qWarning() << "ChartContainer: cannot write" << path << file.errorString();
+        return false;
     }
+    return true;
 }
@@ -11,12 +11,42 @@
 #include <QMap>
 
 #include "noaaweatherfetcher.h"
+#include "Downsampler.h"
+#include "MinMaxPyramid.h"
 
 #if QT_VERSION < QT_VERSION_CHECK(6, 0, 0)
 //using namespace QtCharts;
 #endif
 
-// Class for managing chart visualization of weather data
+// Class for managing chart visualization of weather data.
+//
+// Retained mode: the series and axes are created once and reused.
+// A redraw swaps the points in with one QXYSeries::replace() and
+// moves the axis ranges in place, so memory stays flat however
+// long the chart keeps redrawing.
+//
+// The plot calls only record data. Rendering is deferred to the
+// event loop: every chart changed during one turn is drawn in a
+// single pass afterwards, and a chart whose view is hidden or in a
+// minimized window is not drawn at all until it is shown again.
+// Series and axes are built on the first render, i.e. first show.
+//
+// Lines longer than the view is wide are reduced with LTTB before
+// they reach QtCharts; the full-resolution points stay here. The
+// reduction is redone only when the data or the view width changes.
+//
+// Converting plotted data to points, the min/max scan and LTTB run
+// on a shared background thread, into pooled buffers. The GUI
+// thread only copies the input and, when the result comes back,
+// swaps it in with one replace(). Single appended points that fit
+// the view go straight to the series.
+//
+// renderImage()/saveImage() draw the same chart objects to PNG or
+// SVG on demand, on screen or not.
+//
+// With zoom enabled the time axis can be zoomed and panned. A zoomed
+// window is drawn from a min/max pyramid over the full points, one
+// low/high pair per pixel, instead of LTTB.
 class ChartContainer
 {
 public:
@@ -25,6 +55,13 @@ public:
     // Plot a single weather data series
     void plotWeatherData(const QVector<WeatherData>& weatherData, const QString& yAxisTitle);
 
+    // Plot a contiguous run of points (e.g. a RingHistory window)
+    void plotWeatherData(const WeatherData* points, int count, const QString& yAxisTitle);
+
+    // Add one point to a single-series chart, dropping those more
+    // than keepMs older than it
+    void appendPoint(const WeatherData& point, qint64 keepMs, const QString& yAxisTitle);
+
     // Plot multiple weather data series on the same chart
     void plotWeatherDataMap(const QMap<QString, QVector<WeatherData>>& weatherDataMap);
 
@@ -34,12 +71,90 @@ public:
     // Enable/disable chart animations (disable for rapid updates)
     void setAnimated(bool enabled) { animated = enabled; }
 
+    // Draw the chart as "png" or "svg", bringing pending data in
+    // first. A view on screen is drawn at its own size, a hidden one
+    // (no monitor, or QT_QPA_PLATFORM=offscreen) at 'size'. Empty
+    // for an unknown format.
+    QByteArray renderImage(const QByteArray& format, const QSize& size = QSize(1280, 720));
+
+    // renderImage() into 'path', format from its suffix; the file
+    // is replaced atomically
+    bool saveImage(const QString& path, const QSize& size = QSize(1280, 720));
+
+    // Mouse wheel zooms the time axis around the cursor, dragging
+    // pans it, a double click shows the whole line again
+    void setZoomEnabled(bool enabled) { zoomEnabled = enabled; }
+
 private:
+    struct PrepJob;
+
+    // One line with its own Y axis
+    struct Trace {
+        QtCharts::QLineSeries* series = nullptr;               // Null until first render
+        QtCharts::QValueAxis*  axisY  = nullptr;
+        QVector<QPointF> points;                               // Full resolution, once converted
+        QVector<WeatherData> source;                           // Plotted data not yet converted
+        bool converted  = true;                                // 'points' is current, 'source' empty
+        QVector<QPointF> shown;                                // Buffer 'series' was given
+        quint64 generation = 0;                                // Bumped on every data change
+        bool inFlight   = false;                               // A PrepJob is out for this line
+        QColor color;
+        double minY = 0;
+        double maxY = 0;
+        bool replot     = true;                                // Next render replaces all points
+        int  appended   = 0;                                   // Else: points added at the end
+        int  dropped    = 0;                                   //   and removed at the front
+        int  shownWidth = -1;                                  // Width 'series' was reduced for
+        bool reduced    = false;                               // 'series' is an LTTB subset
+        MinMaxPyramid pyramid;                                 // Over 'points'
+        bool pyramidStale = true;
+    };
+
+    enum class Layout { Empty, Single, Multi };
+
     QtCharts::QChart* chart = new QtCharts::QChart();                              // The chart object
     QtCharts::QChartView* chartview = new QtCharts::QChartView();                  // Widget to display the chart
-    void removeAllAxes();                                      // Helper to clear all axes
+    QtCharts::QDateTimeAxis* axisX = nullptr;                  // Shared time axis, built on first render
+    Trace single;                                              // Layout::Single
+    QString singleTitle;
+    QMap<QString, Trace> traces;                               // Layout::Multi, by name
+    qint64 multiFromMs = 0;                                    // Time span of 'traces'
+    qint64 multiToMs   = 0;
+    Layout layout = Layout::Empty;
+    quint64 generations = 0;                                   // Source of Trace::generation
     QVector<QColor> colors;                                    // Color palette for series
     bool animated = true;                                      // Animation toggle
+    bool dirty    = false;                                     // Data changed since last render
+    bool queued   = false;                                     // In the render queue
+    bool zoomEnabled = false;
+    qint64 viewFromMs = 0;                                     // Zoomed window; empty = whole line
+    qint64 viewToMs   = 0;
+    int    dragX      = -1;                                    // Pan in progress from this pixel
+    qint64 dragFromMs = 0;
+
+    void useLayout(Layout wanted);                             // Drop the other layout's lines
+    void requestRender();                                      // Render on the next loop turn
+    bool isShown() const;                                      // Visible, window not minimized
+    void render(bool now = false);                             // now: even hidden, prepared inline
+    static void renderQueued();                                // Every chart changed this turn
+    void buildTrace(Trace& trace, const QString& yAxisTitle);
+    void removeTrace(Trace& trace);                            // Remove and delete
+    void update(Trace& trace, const QString& key, bool now);   // Pending points -> series
+    void prepare(Trace& trace, const QString& key, bool now);  // Post (or run) a PrepJob
+    static void runPrepJob(PrepJob& job);                      // Any thread
+    void finishPrepare(PrepJob& job);                          // Back on the GUI thread
+    void setRanges(Trace& trace);
+    void setSource(Trace& trace, QVector<WeatherData> data);
+    void onViewShown();
+    void onViewResized();                                      // Re-reduce for the new width
+    int  plotWidth() const { return chartview->width(); }
+    void setTimeRange(qint64 fromMs, qint64 toMs);
+    void applyTimeRange();                                     // Zoomed window or whole line
+    bool zoomed() const { return viewToMs > viewFromMs; }
+    bool dataRange(qint64& fromMs, qint64& toMs) const;
+    void setView(qint64 fromMs, qint64 toMs);                  // Clamped; whole line resets
+    void showEnvelope(Trace& trace);                           // Zoomed window -> series
+    bool onViewInput(QEvent* event);                           // Wheel, drag, double click
 };
 
 #endif // CHARTCONTAINER_H
@@ -0,0 +1,78 @@
+/////////////////////////////////////////////////////////////
+// DAEMON.CPP - Headless Controller Entry Point
+//
+//  smartrainharvestd: the RainController under a
+//  QCoreApplication. No widgets, charts or display; history
+//  and metrics are served on the controller's HTTP endpoint.
+/////////////////////////////////////////////////////////////
+
+#include "RainController.h"
+#include "HistoryExporter.h"
+#include <QCoreApplication>
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QSocketNotifier>
+#include <cstring>
+#ifdef Q_OS_UNIX
+#include <csignal>
+#include <unistd.h>
+#endif
+
+#ifdef Q_OS_UNIX
+// SIGTERM/SIGINT end the event loop (so the controller saves its
+// snapshot) through a pipe: the handler only write()s, which is
+// safe in a signal handler, and the loop reads the other end
+static int signalPipe[2];
+
+static void onSignal(int)
+{
+    const char byte = 1;
+    if (::write(signalPipe[1], &byte, 1) < 0) {
+        // Nothing useful to do in a signal handler
+    }
+}
+
+static void quitOnSignals(QCoreApplication &app)
+{
+    if (::pipe(signalPipe) != 0) {
+        qWarning() << "daemon: no signal pipe; SIGTERM will skip the final snapshot";
+        return;
+    }
+    QSocketNotifier *notifier = new QSocketNotifier(signalPipe[0], QSocketNotifier::Read, &app);
+    // activated() is overloaded from Qt 5.15; the string form picks
+    // the int one on every 5.x
+    QObject::connect(notifier, SIGNAL(activated(int)), &app, SLOT(quit()));
+
+    struct sigaction action;
+    std::memset(&action, 0, sizeof(action));
+    action.sa_handler = onSignal;
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGTERM, &action, nullptr);
+    sigaction(SIGINT, &action, nullptr);
+}
+#endif
+
+int main(int argc, char* argv[])
+{
+    QElapsedTimer startup;
+    startup.start();
+
+    QCoreApplication app(argc, argv);
+    app.setApplicationName("SmartRainHarvest");    // Same data directory as the GUI
+
+    // --export <base> [options]: as for the GUI binary
+    if (argc > 1 && std::strcmp(argv[1], "--export") == 0)
+        return exportHistory(argc, argv);
+
+#ifdef Q_OS_UNIX
+    quitOnSignals(app);
+#endif
+
+    RainController controller;
+    controller.start();
+
+    qInfo() << "smartrainharvestd: started in" << startup.elapsed() << "ms, RSS"
+            << residentSetKiB() << "KiB";
+
+    return app.exec();
+}
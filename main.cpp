@@ -3,11 +3,35 @@
 /////////////////////////////////////////////////////////////
 
 #include "smartrainharvest.h"
+#include "ReadingSerializer.h"
+#include "HistoryExporter.h"
 #include <QApplication>
+#include <QCoreApplication>
+#include <QDebug>
+#include <QElapsedTimer>
+#include <cstdlib>
+#include <cstring>
 
 int main(int argc, char* argv[])
 {
     //Arash testing push
+    QElapsedTimer startup;
+    startup.start();
+
+    // --bench-serializer [readings]: time the JSON encoders and exit
+    // (no display needed)
+    if (argc > 1 && std::strcmp(argv[1], "--bench-serializer") == 0) {
+        QCoreApplication app(argc, argv);
+        int readings = argc > 2 ? std::atoi(argv[2]) : 0;
+        return benchmarkSerializer(readings > 0 ? readings : 200000);
+    }
+
+    // --export <base> [options]: dump stored history to .srcol/.csv
+    // and exit; see exportHistory() for the options
+    if (argc > 1 && std::strcmp(argv[1], "--export") == 0) {
+        QCoreApplication app(argc, argv);
+        return exportHistory(argc, argv);
+    }
 
     // Initialize the Qt application with command-line arguments
     QApplication a(argc, argv);
@@ -18,6 +42,10 @@ int main(int argc, char* argv[])
     // Display the window in maximized mode
     w.showMaximized();
 
+    // Compare with smartrainharvestd, the headless build
+    qInfo() << "SmartRainHarvest: started in" << startup.elapsed() << "ms, RSS"
+            << residentSetKiB() << "KiB";
+
     // Start the Qt event loop and return the exit code when application closes
     return a.exec();
 }
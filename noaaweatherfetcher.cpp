@@ -10,6 +10,7 @@
 #include <QtNetwork/QNetworkRequest>
 #include <QJsonDocument>
 #include <QEventLoop>
+#include <QTimer>
 #include <QJsonObject>
 #include <QJsonArray>
 #include <QDateTime>
@@ -21,10 +22,8 @@ NOAAWeatherFetcher::NOAAWeatherFetcher(QObject* parent) : QObject(parent) {
     manager = new QNetworkAccessManager(this);
 }
 
-// Fetch weather prediction data from NOAA API
-QVector<WeatherData> NOAAWeatherFetcher::getWeatherPrediction(int latitude, int longitude, datatype type) {
-    QVector<WeatherData> weatherData;
-
+// Start a GET for the grid point's forecast document
+QNetworkReply* NOAAWeatherFetcher::requestGridpoint(int latitude, int longitude) {
     // Construct NOAA API URL for the specified grid coordinates
     QString url;
     url = QString("https://api.weather.gov/gridpoints/LWX/%1,%2").arg(latitude).arg(longitude);
@@ -33,6 +32,12 @@ QVector<WeatherData> NOAAWeatherFetcher::getWeatherPrediction(int latitude, int
     // Create HTTP GET request
     QNetworkRequest request((QUrl(url)));
     request.setHeader(QNetworkRequest::ContentTypeHeader, "application/json");
+    return manager->get(request);
+}
+
+// Extract one data type's time series from the document's properties
+QVector<WeatherData> NOAAWeatherFetcher::parsePrediction(const QJsonObject& properties, datatype type) {
+    QVector<WeatherData> weatherData;
 
     // Map data type enum to NOAA API field name
     QString DataType;
@@ -50,10 +55,33 @@ QVector<WeatherData> NOAAWeatherFetcher::getWeatherPrediction(int latitude, int
         DataType = "temperature";
         break;
     }
-    //qDebug() << DataType;
+    //qDebug() << properties[DataType];
+
+    // Extract the time series values array
+    QJsonArray periods = properties[DataType].toObject()["values"].toArray();
+    //qDebug() << periods;
+
+    // Parse each time period's data
+    for (const auto& period : periods) {
+        QJsonObject obj = period.toObject();
+
+        // Extract timestamp and value
+        //qDebug() << obj["validTime"].toString().split("+")[0];
+        QDateTime time = QDateTime::fromString(obj["validTime"].toString().split("+")[0], "yyyy-MM-ddTHH:mm:ss");
+        //qDebug() << time;
+        double value = obj["value"].toDouble();
+
+        weatherData.push_back({ time, value });
+    }
+    return weatherData;
+}
+
+// Fetch weather prediction data from NOAA API
+QVector<WeatherData> NOAAWeatherFetcher::getWeatherPrediction(int latitude, int longitude, datatype type) {
+    QVector<WeatherData> weatherData;
 
     // Send the request
-    QNetworkReply* reply = manager->get(request);
+    QNetworkReply* reply = requestGridpoint(latitude, longitude);
 
     // Wait for the reply to finish (blocking approach for simplicity)
     QEventLoop loop;
@@ -62,28 +90,8 @@ QVector<WeatherData> NOAAWeatherFetcher::getWeatherPrediction(int latitude, int
 
     // Process the response if successful
     if (reply->error() == QNetworkReply::NoError) {
-        QByteArray response = reply->readAll();
-        QJsonDocument jsonResponse = QJsonDocument::fromJson(response);
-        QJsonObject jsonObject = jsonResponse.object();
-        QJsonObject properties = jsonObject["properties"].toObject();
-        //qDebug() << properties[DataType];
-
-        // Extract the time series values array
-        QJsonArray periods = properties[DataType].toObject()["values"].toArray();
-        //qDebug() << periods;
-
-        // Parse each time period's data
-        for (const auto& period : periods) {
-            QJsonObject obj = period.toObject();
-
-            // Extract timestamp and value
-            //qDebug() << obj["validTime"].toString().split("+")[0];
-            QDateTime time = QDateTime::fromString(obj["validTime"].toString().split("+")[0], "yyyy-MM-ddTHH:mm:ss");
-            //qDebug() << time;
-            double value = obj["value"].toDouble();
-
-            weatherData.push_back({ time, value });
-        }
+        QJsonDocument jsonResponse = QJsonDocument::fromJson(reply->readAll());
+        weatherData = parsePrediction(jsonResponse.object()["properties"].toObject(), type);
     }
     else {
         qWarning() << "Error fetching weather data:" << reply->errorString();
@@ -93,6 +101,32 @@ QVector<WeatherData> NOAAWeatherFetcher::getWeatherPrediction(int latitude, int
     return weatherData;
 }
 
+void NOAAWeatherFetcher::fetchPredictions(int latitude, int longitude, const QVector<datatype>& types,
+                                          const std::function<void(const Predictions&)>& done) {
+    QNetworkReply* reply = requestGridpoint(latitude, longitude);
+
+    // The reply as context: no abort once it has finished
+    QTimer::singleShot(timeoutMs, reply, &QNetworkReply::abort);
+
+    connect(reply, &QNetworkReply::finished, this, [reply, types, done]() {
+        Predictions predictions;
+        if (reply->error() == QNetworkReply::NoError) {
+            QJsonDocument jsonResponse = QJsonDocument::fromJson(reply->readAll());
+            QJsonObject properties = jsonResponse.object()["properties"].toObject();
+            for (datatype type : types)
+                predictions[type] = parsePrediction(properties, type);
+        }
+        else {
+            qWarning() << "Error fetching weather data:" << reply->errorString();
+            for (datatype type : types)
+                predictions[type] = QVector<WeatherData>();
+        }
+
+        reply->deleteLater();
+        done(predictions);
+    });
+}
+
 // Calculate cumulative value over a specified number of days
 double calculateCumulativeValue(const QVector<WeatherData>& weatherData, int days) {
     if (weatherData.isEmpty()) return 0.0;
@@ -13,6 +13,8 @@
 #include <QJsonObject>
 #include <QJsonArray>
 #include <QDateTime>
+#include <QMap>
+#include <functional>
 #include <vector>
 #include <iostream>
 
@@ -25,8 +27,6 @@ struct WeatherData {
     double value;         // Value of the measurement
 };
 
-class QChartView;
-
 // Class for fetching weather data from NOAA API
 class NOAAWeatherFetcher : public QObject {
     Q_OBJECT
@@ -37,8 +37,21 @@ public:
     // Fetch weather prediction for specified location and data type
     QVector<WeatherData> getWeatherPrediction(int latitude, int longitude, datatype type);
 
+    // Asynchronous: one request for the grid point, every requested
+    // type parsed from its response (all types come in the same
+    // document). 'done' runs on this object's thread; a failed or
+    // timed-out request gives empty series.
+    typedef QMap<datatype, QVector<WeatherData>> Predictions;
+    void fetchPredictions(int latitude, int longitude, const QVector<datatype>& types,
+                          const std::function<void(const Predictions&)>& done);
+
+    int timeoutMs = 60000;           // Per request, asynchronous fetches only
+
 private:
     QNetworkAccessManager* manager;  // Network manager for HTTP requests
+
+    QNetworkReply* requestGridpoint(int latitude, int longitude);
+    static QVector<WeatherData> parsePrediction(const QJsonObject& properties, datatype type);
 };
 
 // Helper function to calculate cumulative values over time
@@ -1,11 +1,8 @@
 /////////////////////////////////////////////////////////////
-// SMARTRAINHARVEST.CPP - Main Application Logic
+// SMARTRAINHARVEST.CPP - Main Application Window
 //
-//  Two-state architecture:
-//    MONITORING  — slow timer, fetches weather, measures depth,
-//                  evaluates release rules
-//    RELEASING   — fast timer, measures depth, checks if target
-//                  has been reached, shuts valve when done
+//  Charts and info cards over the RainController, which runs
+//  the monitoring / release loop (see RainController.cpp)
 /////////////////////////////////////////////////////////////
 
 #include "smartrainharvest.h"
@@ -13,9 +10,13 @@
 #include <QMap>
 #include <QSplitter>
 #include <QFont>
-#ifdef RasPi
-#include <wiringPi.h>
-#endif
+#include <QSignalBlocker>
+#include <QStandardPaths>
+#include <QStyle>
+#include <QApplication>
+#include <QDir>
+#include <QFileDialog>
+#include "HistoryExporter.h"
 
 // ================================================================
 //  Constructor / Destructor
@@ -30,34 +31,59 @@ SmartRainHarvest::SmartRainHarvest(QWidget *parent)
 
     ui->setupUi(this);
 
-    // Timers
-    monitoringTimer = new QTimer(this);
-    releaseTimer    = new QTimer(this);
-    connect(monitoringTimer, &QTimer::timeout,
-            this, &SmartRainHarvest::onMonitoringTick);
-    connect(releaseTimer, &QTimer::timeout,
-            this, &SmartRainHarvest::onReleaseTick);
-
-    setupDashboard();
-
-    // Hardware
-    distanceSensor.initialize();
-    moistureSensor.initialize();
-#ifdef RasPi
-    pinMode(VALVE_OPEN_PIN, OUTPUT);
-    pinMode(VALVE_CLOSE_PIN, OUTPUT);
-#endif
+    // History buffers
+    cumulativeRainHistory.setCapacity(historyPoints);
+    depthHistory.setCapacity(zoomHistoryPoints);
+    moistureHistory.setCapacity(zoomHistoryPoints);
+    valveHistory.setCapacity(historyPoints);
 
+    controller = new RainController(this);
 
+    setupDashboard();
 
-    shutValve();
-    enterMonitoringMode();
-    QTimer::singleShot(0, this, &SmartRainHarvest::onMonitoringTick);
-
+    // Redraw the charts from the store, so a restart keeps them
+    loadHistory(depthHistory, depthChart, "depth_sensor", QueryAggregate::Mean,
+                "Water Depth (cm)", zoomHistoryDays, zoomHistoryPoints);
+    loadHistory(moistureHistory, moistureChart, "moisture_sensor", QueryAggregate::Mean,
+                "Moisture Level (%)", zoomHistoryDays, zoomHistoryPoints);
+    loadHistory(valveHistory, valveChart, "valve_state", QueryAggregate::Last,
+                "Valve State (on/off)", historyDays, historyPoints);
+    loadHistory(cumulativeRainHistory, cumulativeChart, "cumulative_rain", QueryAggregate::Last,
+                "Cumulative rain forecast [mm]", historyDays, historyPoints);
+
+    // Follow the controller
+    connect(controller, &RainController::changed,
+            this, &SmartRainHarvest::onControllerChanged);
+    connect(controller, &RainController::stateChanged,
+            this, &SmartRainHarvest::onStateChanged);
+    connect(controller, &RainController::pointRecorded,
+            this, &SmartRainHarvest::onPointRecorded);
+    connect(controller, &RainController::forecastUpdated,
+            this, &SmartRainHarvest::plotForecast);
+
+    // Upload pipeline metrics
+    metricsTimer = new QTimer(this);
+    connect(metricsTimer, &QTimer::timeout,
+            this, &SmartRainHarvest::updateUplinkPanel);
+    metricsTimer->start(metricsRefreshMs);
+
+    controller->start();
+
+    if (LocalHttpServer *server = controller->httpServer()) {
+        server->route("/chart", [this](const QUrlQuery &params) {
+            return handleChart(params);
+        });
+    }
 
-    //onMonitoringTick();
+    if (chartImageMinutes > 0) {
+        chartImageTimer = new QTimer(this);
+        connect(chartImageTimer, &QTimer::timeout,
+                this, &SmartRainHarvest::saveChartImages);
+        chartImageTimer->start(chartImageMinutes * 60 * 1000);
+    }
 }
 
+// The controller, a child, saves its snapshot as it goes
 SmartRainHarvest::~SmartRainHarvest()
 {
     delete ui;
@@ -67,50 +93,161 @@ SmartRainHarvest::~SmartRainHarvest()
 //  UI Setup
 // ================================================================
 
+// The whole window's look, parsed once in setupDashboard(). Widgets
+// pick rules by their "role" property and change colour through
+// "level" (DashboardModel::levelName), never with a sheet of their
+// own: a level change restyles one widget from the parsed rules,
+// where setStyleSheet() reparses and repolishes a whole subtree.
+static const char DASHBOARD_STYLE[] = R"(
+    QMainWindow {
+        background-color: #1a1d23;
+    }
+    QSplitter::handle {
+        background-color: #2d3139;
+    }
+    #infoPanel {
+        background-color: #1a1d23;
+    }
+
+    /* Cards */
+    #infoPanel QGroupBox {
+        font-size: 11px;
+        font-weight: bold;
+        color: #78909c;
+        background-color: #21252b;
+        border: 1px solid #2d3139;
+        border-radius: 8px;
+        margin-top: 10px;
+        padding-top: 10px;
+        padding-left: 10px;
+        padding-right: 10px;
+        padding-bottom: 6px;
+    }
+    #infoPanel QGroupBox::title {
+        subcontrol-origin: margin;
+        left: 12px;
+        padding: 0 6px;
+    }
+    #infoPanel QLabel {
+        color: #cfd8dc;
+        background: transparent;
+        border: none;
+    }
+    #infoPanel QLabel[role="value"]                  { color: #eceff1; }
+    #infoPanel QLabel[role="value"][level="normal"]  { color: #26c6da; }
+    #infoPanel QLabel[role="value"][level="wet"]     { color: #42a5f5; }
+    #infoPanel QLabel[role="value"][level="ok"]      { color: #66bb6a; }
+    #infoPanel QLabel[role="value"][level="alarm"]   { color: #ef5350; }
+    #infoPanel QLabel[role="value"][level="offline"] { color: #78909c; }
+    #infoPanel QLabel[role="caption"] {
+        color: #607d8b;
+        font-size: 11px;
+    }
+    #infoPanel QLabel[role="warning"] {
+        color: #ef5350;
+        font-size: 11px;
+        font-weight: bold;
+    }
+    #infoPanel QLabel[role="setting"] {
+        color: #b0bec5;
+        font-size: 12px;
+        font-weight: bold;
+    }
+    #infoPanel QFrame[role="separator"] {
+        background-color: #2d3139;
+        border: none;
+        max-height: 1px;
+    }
+
+    /* Bars and indicator dots */
+    #infoPanel QProgressBar {
+        background-color: #2d3139;
+        border: none;
+        border-radius: 3px;
+    }
+    #infoPanel QProgressBar::chunk {
+        background-color: #26c6da;
+        border-radius: 3px;
+    }
+    #infoPanel QProgressBar[tone="rain"]::chunk {
+        background-color: #42a5f5;
+    }
+    #infoPanel QFrame[role="dot"] {
+        background-color: #78909c;
+        border-radius: 7px;
+        border: none;
+    }
+    #infoPanel QFrame[role="dot"][level="ok"]    { background-color: #66bb6a; }
+    #infoPanel QFrame[role="dot"][level="alarm"] { background-color: #ef5350; }
+
+    /* Controls: buttons are muted unless they act on the valve
+       by hand (ok = will open, alarm = will shut) */
+    #infoPanel QCheckBox {
+        color: #90a4ae;
+        font-size: 12px;
+        spacing: 6px;
+        background: transparent;
+    }
+    #infoPanel QCheckBox::indicator {
+        width: 16px; height: 16px;
+        border-radius: 3px;
+        border: 1px solid #4a5060;
+        background-color: #2b3038;
+    }
+    #infoPanel QCheckBox::indicator:checked {
+        background-color: #0d6efd;
+        border-color: #0d6efd;
+    }
+    #infoPanel QPushButton {
+        background-color: #37474f;
+        color: #78909c;
+        border: 1px solid #455a64;
+        border-radius: 6px;
+        font-weight: bold;
+        font-size: 13px;
+    }
+    #infoPanel QPushButton:hover {
+        background-color: #455a64;
+    }
+    #infoPanel QPushButton[level="ok"] {
+        background-color: #2e7d32;
+        color: white;
+        border: none;
+    }
+    #infoPanel QPushButton[level="ok"]:hover     { background-color: #388e3c; }
+    #infoPanel QPushButton[level="ok"]:pressed   { background-color: #1b5e20; }
+    #infoPanel QPushButton[level="alarm"] {
+        background-color: #d32f2f;
+        color: white;
+        border: none;
+    }
+    #infoPanel QPushButton[level="alarm"]:hover   { background-color: #e53935; }
+    #infoPanel QPushButton[level="alarm"]:pressed { background-color: #b71c1c; }
+)";
+
+// Move a widget to another level: a repolish against the parsed
+// window stylesheet, skipped when the level is unchanged
+static void setLevel(QWidget *widget, DashboardModel::Level level)
+{
+    const char *name = DashboardModel::levelName(level);
+    if (widget->property("level").toByteArray() == name)
+        return;
+    widget->setProperty("level", name);
+    widget->style()->unpolish(widget);
+    widget->style()->polish(widget);
+}
+
 void SmartRainHarvest::setupDashboard()
 {
     setWindowTitle("SmartRainHarvest");
     resize(1400, 900);
 
     // ── Global stylesheet ──────────────────────────────────
-    setStyleSheet(R"(
-        QMainWindow {
-            background-color: #1a1d23;
-        }
-        QSplitter::handle {
-            background-color: #2d3139;
-        }
-    )");
+    setStyleSheet(DASHBOARD_STYLE);
 
     // ── Helper: create an info card ────────────────────────
     auto makeCard = [](const QString &title, QWidget *parent) -> QGroupBox* {
-        QGroupBox *box = new QGroupBox(title, parent);
-        box->setStyleSheet(R"(
-            QGroupBox {
-                font-size: 11px;
-                font-weight: bold;
-                color: #78909c;
-                background-color: #21252b;
-                border: 1px solid #2d3139;
-                border-radius: 8px;
-                margin-top: 10px;
-                padding-top: 10px;
-                padding-left: 10px;
-                padding-right: 10px;
-                padding-bottom: 6px;
-            }
-            QGroupBox::title {
-                subcontrol-origin: margin;
-                left: 12px;
-                padding: 0 6px;
-            }
-            QLabel {
-                color: #cfd8dc;
-                background: transparent;
-                border: none;
-            }
-        )");
-        return box;
+        return new QGroupBox(title, parent);
     };
 
     // ── Helper: big value label ────────────────────────────
@@ -120,45 +257,33 @@ void SmartRainHarvest::setupDashboard()
         f.setPixelSize(28);
         f.setBold(true);
         lbl->setFont(f);
-        lbl->setStyleSheet("color: #eceff1; background: transparent;");
+        lbl->setProperty("role", "value");
         return lbl;
     };
 
     // ── Helper: small label ────────────────────────────────
     auto makeSmallLabel = [](const QString &text) -> QLabel* {
         QLabel *lbl = new QLabel(text);
-        lbl->setStyleSheet("color: #607d8b; font-size: 11px; background: transparent;");
+        lbl->setProperty("role", "caption");
         return lbl;
     };
 
     // ── Helper: progress bar ───────────────────────────────
-    auto makeBar = [](const QString &color) -> QProgressBar* {
+    auto makeBar = [](const char *tone) -> QProgressBar* {
         QProgressBar *bar = new QProgressBar();
         bar->setRange(0, 100);
         bar->setValue(0);
         bar->setTextVisible(false);
         bar->setFixedHeight(6);
-        bar->setStyleSheet(QString(R"(
-            QProgressBar {
-                background-color: #2d3139;
-                border: none;
-                border-radius: 3px;
-            }
-            QProgressBar::chunk {
-                background-color: %1;
-                border-radius: 3px;
-            }
-        )").arg(color));
+        bar->setProperty("tone", tone);
         return bar;
     };
 
     // ── Helper: indicator dot ──────────────────────────────
-    auto makeDot = [](const QString &color) -> QFrame* {
+    auto makeDot = []() -> QFrame* {
         QFrame *dot = new QFrame();
         dot->setFixedSize(14, 14);
-        dot->setStyleSheet(QString(
-                               "background-color: %1; border-radius: 7px; border: none;"
-                               ).arg(color));
+        dot->setProperty("role", "dot");
         return dot;
     };
 
@@ -168,7 +293,7 @@ void SmartRainHarvest::setupDashboard()
 
     QWidget *infoPanel = new QWidget();
     infoPanel->setFixedWidth(260);
-    infoPanel->setStyleSheet("background-color: #1a1d23;");
+    infoPanel->setObjectName("infoPanel");
     QVBoxLayout *infoLayout = new QVBoxLayout(infoPanel);
     infoLayout->setContentsMargins(8, 8, 8, 8);
     infoLayout->setSpacing(0);
@@ -186,12 +311,11 @@ void SmartRainHarvest::setupDashboard()
     depthRow->addStretch();
     depthLay->addLayout(depthRow);
 
-    depthBar = makeBar("#26c6da");
+    depthBar = makeBar("water");
     depthLay->addWidget(depthBar);
 
-    sensorStatusLabel = new QLabel("", depthCard);
-    sensorStatusLabel->setStyleSheet(
-        "color: #ef5350; font-size: 11px; font-weight: bold; background: transparent;");
+    sensorStatusLabel = new QLabel("⚠ Sensor not connected or malfunctioning", depthCard);
+    sensorStatusLabel->setProperty("role", "warning");
     sensorStatusLabel->setWordWrap(true);
     sensorStatusLabel->hide();
     depthLay->addWidget(sensorStatusLabel);
@@ -211,12 +335,11 @@ void SmartRainHarvest::setupDashboard()
     moistureRow->addStretch();
     moistureLay->addLayout(moistureRow);
 
-    moistureBar = makeBar("#26c6da");
+    moistureBar = makeBar("water");
     moistureLay->addWidget(moistureBar);
 
     moistureStatusLabel = new QLabel("", moistureCard);
-    moistureStatusLabel->setStyleSheet(
-        "color: #ef5350; font-size: 11px; font-weight: bold; background: transparent;");
+    moistureStatusLabel->setProperty("role", "warning");
     moistureStatusLabel->setWordWrap(true);
     moistureStatusLabel->hide();
     moistureLay->addWidget(moistureStatusLabel);
@@ -236,7 +359,7 @@ void SmartRainHarvest::setupDashboard()
     rainRow->addStretch();
     rainLay->addLayout(rainRow);
 
-    rainBar = makeBar("#42a5f5");
+    rainBar = makeBar("rain");
     rainLay->addWidget(rainBar);
 
     infoLayout->addWidget(rainCard);
@@ -247,7 +370,7 @@ void SmartRainHarvest::setupDashboard()
     modeLay->setSpacing(0);
 
     QHBoxLayout *modeRow = new QHBoxLayout();
-    modeIndicator  = makeDot("#66bb6a");
+    modeIndicator  = makeDot();
     modeValueLabel = makeBigLabel("MONITORING");
     modeValueLabel->setFont([]{
         QFont f; f.setPixelSize(18); f.setBold(true); return f;
@@ -269,7 +392,7 @@ void SmartRainHarvest::setupDashboard()
     valveLay->setSpacing(0);
 
     QHBoxLayout *valveRow = new QHBoxLayout();
-    valveIndicator  = makeDot("#78909c");
+    valveIndicator  = makeDot();
     valveValueLabel = makeBigLabel("SHUT");
     valveValueLabel->setFont([]{
         QFont f; f.setPixelSize(18); f.setBold(true); return f;
@@ -283,24 +406,6 @@ void SmartRainHarvest::setupDashboard()
     // Auto-control checkbox
     autoControlCheckBox = new QCheckBox("Auto Control", valveCard);
     autoControlCheckBox->setChecked(true);
-    autoControlCheckBox->setStyleSheet(R"(
-        QCheckBox {
-            color: #90a4ae;
-            font-size: 12px;
-            spacing: 6px;
-            background: transparent;
-        }
-        QCheckBox::indicator {
-            width: 16px; height: 16px;
-            border-radius: 3px;
-            border: 1px solid #4a5060;
-            background-color: #2b3038;
-        }
-        QCheckBox::indicator:checked {
-            background-color: #0d6efd;
-            border-color: #0d6efd;
-        }
-    )");
     valveLay->addWidget(autoControlCheckBox);
     connect(autoControlCheckBox, &QCheckBox::toggled,
             this, &SmartRainHarvest::onAutoControlToggled);
@@ -323,30 +428,53 @@ void SmartRainHarvest::setupDashboard()
     auto addThreshRow = [&](int row, const QString &label, const QString &value) {
         QLabel *l = makeSmallLabel(label);
         QLabel *v = new QLabel(value);
-        v->setStyleSheet("color: #b0bec5; font-size: 12px; font-weight: bold; background: transparent;");
+        v->setProperty("role", "setting");
         v->setAlignment(Qt::AlignRight);
         threshGrid->addWidget(l, row, 0);
         threshGrid->addWidget(v, row, 1);
         return v;
     };
 
-    threshOverflowLabel       = addThreshRow(0, "Overflow depth",     QString("%1 cm").arg(overflowThreshold));
-    threshEmptyLabel       = addThreshRow(1, "Empty depth",     QString("%1 cm").arg(emptyThreshold));
-    threshForecastRainLabel   = addThreshRow(2, "Forecast min rain",  QString("%1 mm").arg(forecastThreshold));
-    threshmoistureLabel       = addThreshRow(3, "Moisture threshold",    QString("%1 %").arg(moistureThreshold));
+    threshOverflowLabel       = addThreshRow(0, "Overflow depth",     QString("%1 cm").arg(controller->overflowThreshold));
+    threshEmptyLabel       = addThreshRow(1, "Empty depth",     QString("%1 cm").arg(controller->emptyThreshold));
+    threshForecastRainLabel   = addThreshRow(2, "Forecast min rain",  QString("%1 mm").arg(controller->forecastThreshold));
+    threshmoistureLabel       = addThreshRow(3, "Moisture threshold",    QString("%1 %").arg(controller->moistureThreshold));
 
 
     // Separator line
     QFrame *sep = new QFrame(threshCard);
     sep->setFrameShape(QFrame::HLine);
-    sep->setStyleSheet("background-color: #2d3139; border: none; max-height: 1px;");
+    sep->setProperty("role", "separator");
     threshGrid->addWidget(sep, 4, 0, 1, 2);
 
-    addThreshRow(5, "Monitoring interval", QString("%1 s").arg(monitoringInterval));
-    addThreshRow(6, "Release interval",    QString("%1 s").arg(releaseInterval));
+    addThreshRow(5, "Monitoring interval", QString("%1 s").arg(controller->monitoringInterval));
+    addThreshRow(6, "Release interval",    QString("%1 s").arg(controller->releaseInterval));
 
     infoLayout->addWidget(threshCard);
 
+    // ── Uplink card ────────────────────────────────────────
+    QGroupBox *uplinkCard = makeCard("UPLINK", infoPanel);
+    QVBoxLayout *uplinkLay = new QVBoxLayout(uplinkCard);
+    uplinkLay->setSpacing(0);
+    uplinkLabel = makeSmallLabel("--");
+    uplinkLabel->setWordWrap(true);
+    uplinkLay->addWidget(uplinkLabel);
+    infoLayout->addWidget(uplinkCard);
+
+    // ── History card ───────────────────────────────────────
+    QGroupBox *historyCard = makeCard("HISTORY", infoPanel);
+    QVBoxLayout *historyLay = new QVBoxLayout(historyCard);
+    historyLay->setSpacing(6);
+    exportButton = new QPushButton("Export History...", historyCard);
+    exportButton->setMinimumHeight(30);
+    historyLay->addWidget(exportButton);
+    connect(exportButton, &QPushButton::clicked,
+            this, &SmartRainHarvest::onExportHistory);
+    exportStatusLabel = makeSmallLabel("CSV + columnar, all series");
+    exportStatusLabel->setWordWrap(true);
+    historyLay->addWidget(exportStatusLabel);
+    infoLayout->addWidget(historyCard);
+
     infoLayout->addStretch();
 
     // ════════════════════════════════════════════════════════
@@ -360,6 +488,10 @@ void SmartRainHarvest::setupDashboard()
     hSplitterMiddle->addWidget(cumulativeChart->GetChartView());
     hSplitterMiddle->addWidget(depthChart->GetChartView());
 
+    // Wheel zoom / drag pan across the depth and moisture history
+    depthChart->setZoomEnabled(true);
+    moistureChart->setZoomEnabled(true);
+
     QSplitter *hSplitterBottom = new QSplitter(Qt::Horizontal, vSplitter);
     hSplitterBottom->addWidget(moistureChart->GetChartView());
     hSplitterBottom->addWidget(valveChart->GetChartView());
@@ -390,6 +522,7 @@ void SmartRainHarvest::setupDashboard()
     // Initial state
     updateInfoPanels();
     updateModeIndicator();
+    updateUplinkPanel();
 }
 
 // ================================================================
@@ -398,500 +531,303 @@ void SmartRainHarvest::setupDashboard()
 
 void SmartRainHarvest::updateInfoPanels()
 {
-    // Depth
-    depthValueLabel->setText(QString::number(lastDepth, 'f', 1));
-    int depthPct = qBound(0, static_cast<int>(lastDepth / barrelDepth * 100), 100);
-    depthBar->setValue(depthPct);
-
-    // Moisture
-    moistureValueLabel->setText(QString::number(lastMoisture, 'f', 1));
-    int moisturePct = qBound(0, static_cast<int>(lastMoisture), 100);
-    moistureBar->setValue(moisturePct);
-
-    // Color depth based on danger level
-    if (lastDepth > overflowThreshold)
-        depthValueLabel->setStyleSheet("color: #ef5350; background: transparent;");
-    else
-        depthValueLabel->setStyleSheet("color: #26c6da; background: transparent;");
-
-    // Color moisture based on danger level
-    if (lastMoisture < moistureThreshold)
-        moistureValueLabel->setStyleSheet("color: #ef5350; background: transparent;");
-    else
-        moistureValueLabel->setStyleSheet("color: #26c6da; background: transparent;");
-
-
-
-    // Rain
-    rainValueLabel->setText(QString::number(lastCumRain, 'f', 1));
-    int rainPct = qBound(0, static_cast<int>(lastCumRain / (forecastThreshold * 2) * 100), 100);
-    rainBar->setValue(rainPct);
-
-    if (lastCumRain > forecastThreshold)
-        rainValueLabel->setStyleSheet("color: #42a5f5; background: transparent;");
-    else
-        rainValueLabel->setStyleSheet("color: #eceff1; background: transparent;");
+    panel.setDepth(controller->lastDepth(), controller->barrelDepth,
+                   controller->overflowThreshold, controller->sensorOk());
+    panel.setMoisture(controller->lastMoisture(), controller->moistureThreshold);
+    panel.setRain(controller->lastCumRain(), controller->forecastThreshold);
+    applyPanel();
 }
 
-void SmartRainHarvest::updateModeIndicator()
+// Redraw the cards the model marks as changed; the others keep
+// their widgets untouched
+void SmartRainHarvest::applyPanel()
 {
-    if (state == SystemState::Releasing) {
-        modeValueLabel->setText("RELEASING");
-        modeValueLabel->setStyleSheet("color: #ef5350; background: transparent;");
-        modeIndicator->setStyleSheet(
-            "background-color: #ef5350; border-radius: 7px; border: none;");
+    const int dirty = panel.takeDirty();
+    if (dirty == 0)
+        return;
 
-        if (releaseReason == ReleaseReason::Overflow)
-            modeReasonLabel->setText("Reason: Overflow protection");
-        else if (releaseReason == ReleaseReason::Dry)
-            modeReasonLabel->setText("Reason: Dry soil");
-        else if (releaseReason == ReleaseReason::Forecast)
-            modeReasonLabel->setText("Reason: Rain forcast");
-        else
-            modeReasonLabel->setText("Reason: Rain forecast and dry soil");
-    } else {
-        modeValueLabel->setText("MONITORING");
-        modeValueLabel->setStyleSheet("color: #66bb6a; background: transparent;");
-        modeIndicator->setStyleSheet(
-            "background-color: #66bb6a; border-radius: 7px; border: none;");
-        modeReasonLabel->setText("");
-    }
-
-    // Valve indicator
-    if (valveOpen) {
-        valveValueLabel->setText("OPEN");
-        valveValueLabel->setStyleSheet("color: #ef5350; background: transparent;");
-        valveIndicator->setStyleSheet(
-            "background-color: #ef5350; border-radius: 7px; border: none;");
-    } else {
-        valveValueLabel->setText("SHUT");
-        valveValueLabel->setStyleSheet("color: #66bb6a; background: transparent;");
-        valveIndicator->setStyleSheet(
-            "background-color: #66bb6a; border-radius: 7px; border: none;");
+    if (dirty & DashboardModel::Depth) {
+        const DashboardModel::Reading &depth = panel.depth();
+        depthValueLabel->setText(depth.text());
+        depthBar->setValue(depth.percent);
+        setLevel(depthValueLabel, depth.level);
+        sensorStatusLabel->setVisible(depth.level == DashboardModel::Offline);
     }
-}
 
-void SmartRainHarvest::updateValveButton()
-{
-    if (autoControl) {
-        // Auto mode: button is dimmed/disabled-looking
-        manualButton->setText(valveOpen ? "Shut Valve" : "Open Valve");
-        manualButton->setStyleSheet(R"(
-            QPushButton {
-                background-color: #37474f;
-                color: #78909c;
-                border: 1px solid #455a64;
-                border-radius: 6px;
-                font-weight: bold;
-                font-size: 13px;
-            }
-            QPushButton:hover {
-                background-color: #455a64;
-            }
-        )");
-    } else {
-        // Manual mode: button is bright and active
-        if (valveOpen) {
-            manualButton->setText("Shut Valve");
-            manualButton->setStyleSheet(R"(
-                QPushButton {
-                    background-color: #d32f2f;
-                    color: white;
-                    border: none;
-                    border-radius: 6px;
-                    font-weight: bold;
-                    font-size: 13px;
-                }
-                QPushButton:hover {
-                    background-color: #e53935;
-                }
-                QPushButton:pressed {
-                    background-color: #b71c1c;
-                }
-            )");
-        } else {
-            manualButton->setText("Open Valve");
-            manualButton->setStyleSheet(R"(
-                QPushButton {
-                    background-color: #2e7d32;
-                    color: white;
-                    border: none;
-                    border-radius: 6px;
-                    font-weight: bold;
-                    font-size: 13px;
-                }
-                QPushButton:hover {
-                    background-color: #388e3c;
-                }
-                QPushButton:pressed {
-                    background-color: #1b5e20;
-                }
-            )");
-        }
+    if (dirty & DashboardModel::Moisture) {
+        const DashboardModel::Reading &moisture = panel.moisture();
+        moistureValueLabel->setText(moisture.text());
+        moistureBar->setValue(moisture.percent);
+        setLevel(moistureValueLabel, moisture.level);
     }
-}
-
-// ================================================================
-//  State Transitions
-// ================================================================
 
-void SmartRainHarvest::enterMonitoringMode()
-{
-    state = SystemState::Monitoring;
-
-    releaseTimer->stop();
-    monitoringTimer->start(monitoringInterval * 1000);
+    if (dirty & DashboardModel::Rain) {
+        const DashboardModel::Reading &rain = panel.rain();
+        rainValueLabel->setText(rain.text());
+        rainBar->setValue(rain.percent);
+        setLevel(rainValueLabel, rain.level);
+    }
 
-    depthChart->setAnimated(true);
-    valveChart->setAnimated(true);
-    cumulativeChart->setAnimated(true);
-    moistureChart->setAnimated(true);
+    if (dirty & DashboardModel::Mode) {
+        const DashboardModel::Level level = panel.releasing() ? DashboardModel::Alarm
+                                                              : DashboardModel::Ok;
+        modeValueLabel->setText(panel.releasing() ? "RELEASING" : "MONITORING");
+        modeReasonLabel->setText(panel.reason());
+        setLevel(modeValueLabel, level);
+        setLevel(modeIndicator, level);
+    }
 
-    updateModeIndicator();
+    if (dirty & DashboardModel::Valve) {
+        const DashboardModel::Level level = panel.valveOpen() ? DashboardModel::Alarm
+                                                              : DashboardModel::Ok;
+        valveValueLabel->setText(panel.valveOpen() ? "OPEN" : "SHUT");
+        setLevel(valveValueLabel, level);
+        setLevel(valveIndicator, level);
+    }
 
-    //qDebug() << "-> MONITORING mode (interval:"
-    //         << monitoringInterval << "s)";
+    // Auto mode: button is dimmed. Manual mode: green to open,
+    // red to shut
+    if (dirty & DashboardModel::Button) {
+        manualButton->setText(panel.valveOpen() ? "Shut Valve" : "Open Valve");
+        setLevel(manualButton, panel.autoControl() ? DashboardModel::Plain
+                               : panel.valveOpen() ? DashboardModel::Alarm
+                                                   : DashboardModel::Ok);
+    }
 }
 
-void SmartRainHarvest::enterReleaseMode()
+// One short block per sink: latency, queues, traffic and losses
+void SmartRainHarvest::updateUplinkPanel()
 {
-    // Only auto-release if auto control is on
-    if (!autoControl) {
-        //qDebug() << "Auto control OFF — skipping release";
-        return;
+    QStringList blocks;
+    for (const SinkMetrics &m : controller->uplink().metrics()) {
+        QString block = QString("%1 (%2)").arg(m.name, m.type);
+        if (!m.breaker.isEmpty() && m.breaker != "closed")
+            block += " — breaker " + m.breaker;
+        block += QString("\n  p50 %1 ms · p95 %2 ms")
+                     .arg(m.latency.quantileMs(0.50))
+                     .arg(m.latency.quantileMs(0.95));
+        block += QString("\n  %1 in flight · %2 queued · %3 on disk")
+                     .arg(m.inFlight).arg(m.queueDepth).arg(m.backlog);
+        block += QString("\n  %1 KB sent · %2 retries · %3 dropped")
+                     .arg(m.bytesSent / 1024).arg(m.retries).arg(m.readingsDropped);
+        blocks << block;
     }
 
-    state = SystemState::Releasing;
-
-    depthChart->setAnimated(false);
-    valveChart->setAnimated(false);
-    cumulativeChart->setAnimated(false);
-    moistureChart->setAnimated(false);
-
-    openValve();
-    recordValveState();
-    dbWriter.sendValveState(true);
-
-    monitoringTimer->stop();
-    releaseTimer->start(releaseInterval * 1000);
-
-    updateModeIndicator();
-    updateValveButton();
+    const TickMetrics &tick = controller->tickMetrics();
+    if (tick.ticks > 0)
+        blocks << QString("Tick: p50 %1 ms · p95 %2 ms\n  %3 decided early · %4 skipped")
+                      .arg(tick.stages[TickMetrics::Total].quantileMs(0.50))
+                      .arg(tick.stages[TickMetrics::Total].quantileMs(0.95))
+                      .arg(tick.earlyDecisions).arg(tick.overruns);
+    uplinkLabel->setText(blocks.isEmpty() ? "No sinks" : blocks.join("\n"));
 }
 
-// ================================================================
-//  MONITORING tick
-// ================================================================
-
-void SmartRainHarvest::onMonitoringTick()
+void SmartRainHarvest::updateModeIndicator()
 {
-    //qDebug() << "-- Monitoring tick --";
-
-
-    if (autoControl)
-    {
-        if (checkIfShouldRelease()) // Enter release mode if conditions are met.
-        {
-            enterReleaseMode();
-            return;
-        }
+    const bool releasing = controller->state() == SystemState::Releasing;
+    const ReleaseReason releaseReason = controller->releaseReason();
+    QString reason;
+    if (releasing) {
+        if (releaseReason == ReleaseReason::Overflow)
+            reason = "Reason: Overflow protection";
+        else if (releaseReason == ReleaseReason::Dry)
+            reason = "Reason: Dry soil";
+        else if (releaseReason == ReleaseReason::Forecast)
+            reason = "Reason: Rain forcast";
+        else
+            reason = "Reason: Rain forecast and dry soil";
     }
+    panel.setMode(releasing, reason);
+    panel.setValve(controller->valveOpen(), controller->autoControl());
+    applyPanel();
+}
 
-
-    recordValveState();
+void SmartRainHarvest::updateValveButton()
+{
+    panel.setValve(controller->valveOpen(), controller->autoControl());
+    applyPanel();
 }
 
 // ================================================================
-//  RELEASE tick
+//  Controller Events
 // ================================================================
 
-void SmartRainHarvest::onReleaseTick()
+void SmartRainHarvest::onControllerChanged()
 {
-    //qDebug() << "-- Release tick --";
-
-
-
-    if (!checkIfShouldRelease()) // Enter monitoring mode if conditions are met.
     {
-
-        shutValve();
-        recordValveState();
-        dbWriter.sendValveState(false);
-
-        enterMonitoringMode();
-        updateValveButton();
-    }
-    else
-    {
-
-        recordValveState();
-        dbWriter.sendValveState(true);
+        QSignalBlocker blocker(autoControlCheckBox);
+        autoControlCheckBox->setChecked(controller->autoControl());
     }
+    updateInfoPanels();
+    updateModeIndicator();
 }
 
-// ================================================================
-//  Auto Control Toggle
-// ================================================================
-
-void SmartRainHarvest::onAutoControlToggled(bool checked)
+// Animate while monitoring; release ticks come too fast for it
+void SmartRainHarvest::onStateChanged(SystemState state)
 {
-    autoControl = checked;
-
-    if (checked) {
-        //qDebug() << "Auto control ENABLED";
-
-        // If valve was manually opened, shut it and reset
-        if (valveOpen && state != SystemState::Releasing) {
-            shutValve();
-            recordValveState();
-            dbWriter.sendValveState(false);
-        }
-
-        // Make sure we're in monitoring mode
-        if (state != SystemState::Monitoring)
-            enterMonitoringMode();
-
-        updateModeIndicator();
-    } else {
-        //qDebug() << "Auto control DISABLED (manual mode)";
-
-        // If currently releasing, stop
-        if (state == SystemState::Releasing) {
-            shutValve();
-            recordValveState();
-            dbWriter.sendValveState(false);
-            enterMonitoringMode();
-        }
-    }
-
-    updateValveButton();
+    const bool animated = state == SystemState::Monitoring;
+    depthChart->setAnimated(animated);
+    valveChart->setAnimated(animated);
+    cumulativeChart->setAnimated(animated);
+    moistureChart->setAnimated(animated);
 }
 
-// ================================================================
-//  Manual Override
-// ================================================================
-
-void SmartRainHarvest::onManualOpenShut()
+// Add a recorded sample to its history and chart
+void SmartRainHarvest::onPointRecorded(const QString &seriesId, const WeatherData &point)
 {
-    // Uncheck auto control
-    autoControlCheckBox->setChecked(false);
-    autoControl = false;
-
-    if (valveOpen) {
-        shutValve();
-
-        if (state == SystemState::Releasing)
-            enterMonitoringMode();
+    RingHistory<WeatherData> *history;
+    ChartContainer *chart;
+    QString title;
+    int days = historyDays;
+    if (seriesId == "depth_sensor") {
+        history = &depthHistory;          chart = depthChart;      title = "Water Depth (cm)";
+        days    = zoomHistoryDays;
+    } else if (seriesId == "moisture_sensor") {
+        history = &moistureHistory;       chart = moistureChart;   title = "Moisture Level (%)";
+        days    = zoomHistoryDays;
+    } else if (seriesId == "valve_state") {
+        history = &valveHistory;          chart = valveChart;      title = "Valve State (on/off)";
+    } else if (seriesId == "cumulative_rain") {
+        history = &cumulativeRainHistory; chart = cumulativeChart; title = "Cumulative rain forecast [mm]";
     } else {
-        openValve();
+        return;
     }
 
-    recordValveState();
-    dbWriter.sendValveState(valveOpen);
-    updateModeIndicator();
-    updateValveButton();
+    // Kept for the span loadHistory() covers, however often points come
+    history->append(point);
+    chart->appendPoint(history->last(), days * 24 * 3600 * 1000LL, title);
 }
 
 // ================================================================
-//  Depth Measurement
+//  Auto Control / Manual Override
 // ================================================================
 
-double SmartRainHarvest::measureDepth()
+void SmartRainHarvest::onAutoControlToggled(bool checked)
 {
-    double raw = distanceSensor.getDistance();
-
-    // Sensor returned error (-1)
-    if (raw < 0) {
-        sensorFailCount++;
-        qWarning() << "Sensor read failed (" << sensorFailCount
-                   << "/" << MAX_SENSOR_FAILS << ")";
-
-        if (sensorFailCount >= MAX_SENSOR_FAILS) {
-            sensorStatusLabel->setText(
-                "⚠ Sensor not connected or malfunctioning");
-            sensorStatusLabel->show();
-            depthValueLabel->setText("--");
-            depthValueLabel->setStyleSheet(
-                "color: #78909c; background: transparent;");
-            depthBar->setValue(0);
-        }
-
-        return lastDepth;  // Return last known good value
-    }
-
-    // Sensor OK — reset fail counter
-    if (sensorFailCount >= MAX_SENSOR_FAILS) {
-        sensorStatusLabel->hide();  // Clear error when sensor recovers
-    }
-    sensorFailCount = 0;
-
-    double depth = barrelDepth - raw;
-
-    if (depth > barrelDepth) depth = barrelDepth;
-    if (depth < 0)           depth = 0;
-
-    //qDebug() << "Depth:" << depth << "cm (raw sensor:" << raw << "cm)";
-    return depth;
+    controller->setAutoControl(checked);
 }
 
-double SmartRainHarvest::measureMoisture()
+void SmartRainHarvest::onManualOpenShut()
 {
-    double raw = moistureSensor.getMoisture();
-
-    double moisture = raw;
-
-    return moisture;
+    controller->toggleValve();
 }
 
-
-
 // ================================================================
-//  Valve Control
+//  History Export
 // ================================================================
 
-void SmartRainHarvest::openValve()
+void SmartRainHarvest::onExportHistory()
 {
-#ifdef RasPi
-   //digitalWrite(VALVE_PIN, HIGH);
-   digitalWrite(VALVE_CLOSE_PIN, LOW);
-   delay(50);
-
-   digitalWrite(VALVE_OPEN_PIN, HIGH);
-   delay(VALVE_PULSE_MS);
-   digitalWrite(VALVE_OPEN_PIN, LOW);
-#endif
-    //qDebug() << "VALVE OPENED";
-
-    valveOpen = true;
-}
-
-void SmartRainHarvest::shutValve()
-{
-#ifdef RasPi
-    //digitalWrite(VALVE_PIN, LOW);
-    digitalWrite(VALVE_OPEN_PIN, LOW);
-    delay(50);
-    digitalWrite(VALVE_CLOSE_PIN, LOW);
-    digitalWrite(VALVE_CLOSE_PIN, HIGH);
-    delay(VALVE_PULSE_MS);
-    //digitalWrite(VALVE_CLOSE_PIN, LOW);
-#endif
-    //qDebug() << "VALVE SHUT";
-
-    valveOpen = false;
+    const QString defaultPath =
+        QStandardPaths::writableLocation(QStandardPaths::DocumentsLocation)
+        + "/history-" + QDateTime::currentDateTime().toString("yyyyMMdd-HHmm");
+    QString basePath = QFileDialog::getSaveFileName(this, "Export History", defaultPath,
+                                                    "CSV + columnar (*.csv *.srcol)");
+    if (basePath.isEmpty())
+        return;
+    if (basePath.endsWith(".csv") || basePath.endsWith(".srcol"))
+        basePath = basePath.left(basePath.lastIndexOf('.'));
+
+    // Synchronous: a season of history takes seconds, and the
+    // store is only read
+    QApplication::setOverrideCursor(Qt::WaitCursor);
+    HistoryExporter exporter(controller->history());
+    const bool ok = exporter.exportRange(basePath, QStringList(), 0,
+                                         QDateTime::currentMSecsSinceEpoch());
+    QApplication::restoreOverrideCursor();
+
+    if (ok)
+        exportStatusLabel->setText(QString("%1 rows, %2 MiB in %3 ms")
+                                       .arg(exporter.rowsWritten())
+                                       .arg(exporter.bytesWritten() / 1048576.0, 0, 'f', 1)
+                                       .arg(exporter.elapsedMs()));
+    else
+        exportStatusLabel->setText("Export failed");
 }
 
 // ================================================================
-//  Data Recording
+//  Charts
 // ================================================================
 
-void SmartRainHarvest::recordDepth(double depth)
+// Refill a history from the store: the last 'days', in buckets sized
+// so no more than 'points' come back (at least a minute)
+void SmartRainHarvest::loadHistory(RingHistory<WeatherData> &history,
+                                   ChartContainer *chart, const QString &seriesId,
+                                   QueryAggregate aggregate, const QString &title,
+                                   int days, int points)
 {
-    if (depthHistory.count() > MAX_HISTORY)
-        depthHistory.removeFirst();
-    depthHistory.append({QDateTime::currentDateTime(), depth});
-    depthChart->plotWeatherData(depthHistory, "Water Depth (cm)");
-}
+    const qint64 spanMs   = days * 24 * 3600 * 1000LL;
+    const qint64 bucketMs = qMax<qint64>(60 * 1000, spanMs / qMax(1, points));
+    const qint64 now = QDateTime::currentMSecsSinceEpoch();
+    const QueryResult result = controller->history().query(seriesId, now - spanMs, now,
+                                                          bucketMs, aggregate);
+    if (result.buckets.isEmpty())
+        return;
 
-void SmartRainHarvest::recordValveState()
-{
-    if (valveHistory.count() > MAX_HISTORY)
-        valveHistory.removeFirst();
-    valveHistory.append({QDateTime::currentDateTime(),
-                         static_cast<double>(valveOpen)});
-    valveChart->plotWeatherData(valveHistory, "Valve State (on/off)");
+    for (const QueryBucket &b : result.buckets)
+        history.append({QDateTime::fromMSecsSinceEpoch(b.startMs), b.value});
+    chart->plotWeatherData(history.data(), history.size(), title);
 }
 
-void SmartRainHarvest::recordMoisture(double moisture)
+ChartContainer *SmartRainHarvest::chartByName(const QString &name) const
 {
-    if (moistureHistory.count() > MAX_HISTORY)
-        moistureHistory.removeFirst();
-    moistureHistory.append({QDateTime::currentDateTime(), moisture});
-    moistureChart->plotWeatherData(moistureHistory, "Moisture Level (%)");
+    if (name == "weather")  return weatherChart;
+    if (name == "rain")     return cumulativeChart;
+    if (name == "depth")    return depthChart;
+    if (name == "moisture") return moistureChart;
+    if (name == "valve")    return valveChart;
+    return nullptr;
 }
 
+// Written over in place (atomically), so a web server or rsync can
+// pick them up at any time
+void SmartRainHarvest::saveChartImages()
+{
+    const QString dir = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation)
+                        + "/charts";
+    if (!QDir().mkpath(dir)) {
+        qWarning() << "Cannot create" << dir;
+        return;
+    }
 
+    for (const char *name : { "weather", "rain", "depth", "moisture", "valve" })
+        chartByName(name)->saveImage(dir + "/" + name + ".png");
+}
 
-bool SmartRainHarvest::checkIfShouldRelease()
+// GET /chart?name=depth&format=png&width=1280&height=720
+LocalHttpServer::Response SmartRainHarvest::handleChart(const QUrlQuery &params)
 {
-    // Check states.
-    lastDepth = measureDepth();
-    recordDepth(lastDepth);
-    dbWriter.sendDepthReading(lastDepth);
-
-    lastMoisture = measureMoisture();
-    recordMoisture(lastMoisture);
-    dbWriter.sendMoistureReading(lastMoisture);
+    LocalHttpServer::Response r;
+    ChartContainer *chart = chartByName(params.queryItemValue("name"));
+    const QByteArray format = params.hasQueryItem("format")
+                                  ? params.queryItemValue("format").toLatin1() : "png";
+    const int width  = params.hasQueryItem("width") ? params.queryItemValue("width").toInt() : 1280;
+    const int height = params.hasQueryItem("height") ? params.queryItemValue("height").toInt() : 720;
+
+    const QByteArray image = chart && width > 0 && height > 0 && width <= 4096 && height <= 4096
+                                 ? chart->renderImage(format, QSize(width, height))
+                                 : QByteArray();
+    if (image.isEmpty()) {
+        r.status = 400;
+        r.body = "usage: /chart?name=<weather|rain|depth|moisture|valve>&format=<png|svg>"
+                 "&width=<px>&height=<px>\n";
+        return r;
+    }
 
+    r.contentType = format == "svg" ? "image/svg+xml" : "image/png";
+    r.body = image;
+    return r;
+}
 
-    // 1. Fetch weather
-    QVector<WeatherData> rainAmount = fetcher.getWeatherPrediction(
-        gridX, gridY, datatype::PrecipitationAmount);
-    QVector<WeatherData> rainProb = fetcher.getWeatherPrediction(
-        gridX, gridY, datatype::ProbabilityofPrecipitation);
-    QVector<WeatherData> temp = fetcher.getWeatherPrediction(
-        gridX, gridY, datatype::Temperature);
+void SmartRainHarvest::plotForecast()
+{
+    if (controller->rainAmount().isEmpty() && controller->rainProb().isEmpty()
+        && controller->temperature().isEmpty())
+        return;
 
     QMap<QString, QVector<WeatherData>> forecastMap;
-    forecastMap["Precipitation [mm]"]            = rainAmount;
-    forecastMap["Precipitation probability (%)"] = rainProb;
-    forecastMap["Temperature (<sup>o</sup>C)"]   = temp;
+    forecastMap["Precipitation [mm]"]            = controller->rainAmount();
+    forecastMap["Precipitation probability (%)"] = controller->rainProb();
+    forecastMap["Temperature (<sup>o</sup>C)"]   = controller->temperature();
     weatherChart->plotWeatherDataMap(forecastMap);
-    weatherChart->GetChartView()->setRenderHint(QPainter::Antialiasing);
-
-    dbWriter.sendWeatherData("precip_amount", "mm",  rainAmount);
-    dbWriter.sendWeatherData("precip_prob",   "%",   rainProb);
-    dbWriter.sendWeatherData("temperature",   "C",   temp);
-
-    // 2. Cumulative rain
-    lastCumRain = calculateCumulativeValue(rainAmount, 2);
-
-    //qDebug() << "Cumulative rain (2-day):" << lastCumRain << "mm from" << rainAmount.size() << "data points";
-
-
-
-    // Keep cumulative rain chart updating with last known value
-    if (cumulativeRainHistory.count() > MAX_HISTORY)
-        cumulativeRainHistory.removeFirst();
-    cumulativeRainHistory.append({QDateTime::currentDateTime(), lastCumRain});
-    //cumulativeChart->setAnimated(false);
-    cumulativeChart->plotWeatherData(cumulativeRainHistory,
-                                     "Cumulative rain forecast [mm]");
-
-
-
-    // Safety: if sensor fails repeatedly during release, shut valve
-    if (sensorFailCount >= MAX_SENSOR_FAILS && state == SystemState::Releasing) {
-        qWarning() << "Sensor failed during release — shutting valve for safety";
-        shutValve();
-        recordValveState();
-        dbWriter.sendValveState(false);
-        enterMonitoringMode();
-        updateValveButton();
-        return false;
-    }
-
-
-
-
-    releaseReason = ReleaseReason::None;
-
-    if (lastMoisture < moistureThreshold && lastCumRain < forecastThreshold)
-        releaseReason = ReleaseReason::DryAndForecast;
-    else if (lastMoisture < moistureThreshold)
-        releaseReason = ReleaseReason::Dry;
-    else if (lastCumRain < forecastThreshold)
-        releaseReason = ReleaseReason::Forecast;
-    if (lastDepth > overflowThreshold)
-        releaseReason = ReleaseReason::Overflow;
-
-
-    updateInfoPanels();
-    SmartRainHarvest::updateModeIndicator();
-
-
-    // Decide state.
-    return (!(lastDepth < emptyThreshold || lastMoisture > moistureThreshold || lastCumRain > forecastThreshold )
-            || lastDepth > overflowThreshold); // Release
-
 }
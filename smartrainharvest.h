@@ -6,11 +6,10 @@
 #define SMARTRAINHARVEST_H
 
 #include <QMainWindow>
-#include "noaaweatherfetcher.h"
+#include "RainController.h"
 #include "chartcontainer.h"
-#include "DistanceSensor.h"
-#include "MoistureSensor.h"
-#include "DatabaseWriter.h"
+#include "RingHistory.h"
+#include "DashboardModel.h"
 #include <QTimer>
 #include <QPushButton>
 #include <QLabel>
@@ -30,20 +29,9 @@ QT_BEGIN_NAMESPACE
 namespace Ui { class SmartRainHarvest; }
 QT_END_NAMESPACE
 
-// ── System operating states ────────────────────────────────
-enum class SystemState {
-    Monitoring,
-    Releasing
-};
-
-enum class ReleaseReason {
-    None,
-    Overflow,
-    Forecast,
-    Dry,
-    DryAndForecast
-};
-
+// The dashboard: charts and info cards over a RainController, which
+// does the actual control (see RainController.h). The headless
+// daemon runs the same controller without this window.
 class SmartRainHarvest : public QMainWindow
 {
     Q_OBJECT
@@ -53,93 +41,48 @@ public:
     ~SmartRainHarvest();
 
     // ── Tunable parameters ─────────────────────────────────
-
-    // Physical distance from the ultrasonic sensor (mounted at top)
-    // to the bottom of the barrel. All depth readings are calculated
-    // as: depth = barrelDepth − sensorReading
-    double barrelDepth = 137.16;                        // cm
-
-    // Forecast-based release triggers when BOTH conditions are met:
-    //   1. Current water depth  >  forecastReleaseDepthThreshold
-    //   2. 2-day cumulative rain >  forecastReleaseThreshold
-    // The system then drains down to forecastTargetDepth.
-    double forecastThreshold      = 15;       // mm  — min predicted rain (2-day sum)
-    double moistureThreshold      = 20;      // %  — minimum soil moisture to consider draining
-
-    // Overflow protection triggers when:
-    //   Current water depth  >  overflowThreshold
-    // This fires regardless of the rain forecast (safety mechanism).
-    // The system drains down to overflowTargetDepth.
-    double overflowThreshold     = 124;               // cm  — emergency release trigger
-    double emptyThreshold     = 13;                 // cm  — point at which the barrel is empty.
-    int monitoringInterval  = 3600;                    // Interval during closed valve mode (seconds)
-    int releaseInterval     = 300;                     // Interval during open valve mode (seconds)
-    bool sensorEnabled      = true;
+    // Control tunables live on the controller
+    int historyDays         = 3;                       // Span of each history chart, loaded and live
+    int historyPoints       = 3 * 24 * 60;             // Most points loaded per history chart
+
+    // The zoomable depth and moisture charts span months instead,
+    // loaded in coarser buckets
+    int zoomHistoryDays     = 90;
+    int zoomHistoryPoints   = 90 * 24 * 4;             // 15-minute buckets
+    int metricsRefreshMs    = 5000;                    // Uplink card refresh
+
+    // Chart images: every chartImageMinutes each chart is written
+    // to <data dir>/charts/<name>.png (0 = off), and /chart?name=
+    // depth&format=png|svg draws one on request. With no monitor,
+    // run under QT_QPA_PLATFORM=offscreen.
+    int chartImageMinutes   = 0;
 
 private slots:
-    void onMonitoringTick();
-    void onReleaseTick();
     void onManualOpenShut();
     void onAutoControlToggled(bool checked);
-    bool checkIfShouldRelease();
+    void onExportHistory();
+    void onControllerChanged();
+    void onStateChanged(SystemState state);
+    void onPointRecorded(const QString &seriesId, const WeatherData &point);
 
 private:
-    // ── State ──────────────────────────────────────────────
-    SystemState   state         = SystemState::Monitoring;
-    ReleaseReason releaseReason = ReleaseReason::None;
-    bool          valveOpen     = false;
-    bool          autoControl   = true;
-    double        lastDepth     = 0;
-    double        lastMoisture  = 0;
-    double        lastCumRain   = 0;
-
-    // ── Hardware ───────────────────────────────────────────
-    //const int VALVE_PIN = 18;
-    static constexpr int VALVE_OPEN_PIN = 18;
-    static constexpr int VALVE_CLOSE_PIN = 23;
-    static constexpr int VALVE_PULSE_MS = 5000;
-
-    DistanceSensor distanceSensor;
-    void openValve();
-    void shutValve();
-
-    MoistureSensor moistureSensor;
-
-    // ── Depth measurement ──────────────────────────────────
-    double measureDepth();
-    int sensorFailCount = 0;           // Consecutive failed readings
-    static const int MAX_SENSOR_FAILS = 3;  // Show error after this many
-
-    // ── Soil moisture measurement ─────────────────────────-
-    double measureMoisture();
-
-
-
-    // ── State transitions ──────────────────────────────────
-    void enterReleaseMode();
-    void enterMonitoringMode();
-
-
+    RainController *controller;
 
     // ── Timers ─────────────────────────────────────────────
-    QTimer *monitoringTimer;
-    QTimer *releaseTimer;
+    QTimer *metricsTimer;
 
     // ── Weather ────────────────────────────────────────────
-    NOAAWeatherFetcher fetcher;
-    int gridX = 97;
-    int gridY = 71;
+    void plotForecast();
 
     // ── Data history ───────────────────────────────────────
-    QVector<WeatherData> cumulativeRainHistory;
-    QVector<WeatherData> depthHistory;
-    QVector<WeatherData> moistureHistory;
-    QVector<WeatherData> valveHistory;
-    static const int MAX_HISTORY = 100;
+    RingHistory<WeatherData> cumulativeRainHistory;
+    RingHistory<WeatherData> depthHistory;
+    RingHistory<WeatherData> moistureHistory;
+    RingHistory<WeatherData> valveHistory;
 
-    void recordDepth(double depth);
-    void recordMoisture(double moisture);
-    void recordValveState();
+    void loadHistory(RingHistory<WeatherData> &history, ChartContainer *chart,
+                     const QString &seriesId, QueryAggregate aggregate,
+                     const QString &title, int days, int points);
 
     // ── UI setup ───────────────────────────────────────────
     Ui::SmartRainHarvest *ui;
@@ -147,6 +90,12 @@ private:
     void updateInfoPanels();
     void updateModeIndicator();
     void updateValveButton();
+    void updateUplinkPanel();
+
+    // The update*() calls feed the model; applyPanel() redraws
+    // only the cards it reports changed
+    DashboardModel panel;
+    void applyPanel();
 
     // ── Charts ─────────────────────────────────────────────
     ChartContainer *weatherChart    = new ChartContainer();
@@ -155,6 +104,12 @@ private:
     ChartContainer *moistureChart   = new ChartContainer();
     ChartContainer *valveChart      = new ChartContainer();
 
+    // weather, rain, depth, moisture, valve
+    ChartContainer *chartByName(const QString &name) const;
+    QTimer *chartImageTimer = nullptr;
+    void saveChartImages();
+    LocalHttpServer::Response handleChart(const QUrlQuery &params);
+
     // ── Info panel labels ──────────────────────────────────
     QLabel *depthValueLabel;
     QLabel *depthUnitLabel;
@@ -177,6 +132,8 @@ private:
     QLabel *valveValueLabel;
     QFrame *valveIndicator;
 
+    QLabel *uplinkLabel;
+
     // ── Threshold labels ───────────────────────────────────
     QLabel *threshOverflowLabel;
     QLabel *threshEmptyLabel;
@@ -186,9 +143,8 @@ private:
     // ── Controls ───────────────────────────────────────────
     QPushButton *manualButton;
     QCheckBox   *autoControlCheckBox;
-
-    // ── Database ───────────────────────────────────────────
-    DatabaseWriter dbWriter;
+    QPushButton *exportButton;
+    QLabel      *exportStatusLabel;
 };
 
 #endif // SMARTRAINHARVEST_H